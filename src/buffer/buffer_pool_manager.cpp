@@ -1,222 +1,377 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
-
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type)
     : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+  // Do not split small pools into shards too small to hold a working set.
+  num_instances = std::min(num_instances, std::max<size_t>(1, pool_size_ / MIN_FRAMES_PER_INSTANCE));
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t instance_size = pool_size_ / num_instances + (i < pool_size_ % num_instances ? 1 : 0);
+    instances_.push_back(new BufferPoolManagerInstance(instance_size, disk_manager_, replacer_type));
   }
 }
 
+namespace {
+constexpr uint32_t RESIDENT_PAGES_DUMP_MAGIC = 0x42504450;  // "BPDP"
+}  // namespace
+
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  StopWarmup();
+  StopBackgroundWriter();
+  {
+    lock_guard<mutex> lock(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  for (auto &worker : io_workers_) {
+    worker.join();
+  }
+#ifndef NDEBUG
+  // 调试模式下检查 pin 泄漏，每个仍被 pin 的页都会由 CheckAllUnpinned 打印出来
+  if (!CheckAllUnpinned()) {
+    LOG(ERROR) << "Buffer pool destroyed with pinned pages, some FetchPage/NewPage is missing its UnpinPage";
+  }
+#endif
+  for (auto instance : instances_) {
+    delete instance;
   }
-  delete[] pages_;
-  delete replacer_;
 }
 
-
-/**
- * TODO: Student Implement
- */
 /**
  * Fetches a page from the buffer pool.
- * 
+ *
  * @param page_id The ID of the page to fetch.
- * @return A pointer to the fetched page, or nullptr if the page does not exist or all pages in the buffer pool are pinned.
+ * @return A pointer to the fetched page, or nullptr if the page does not exist or all pages of its shard are pinned.
  */
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  unique_lock<recursive_mutex> lock(latch_);
-  if(page_id == INVALID_PAGE_ID)
+  if (page_id == INVALID_PAGE_ID) {
     return nullptr;
+  }
+  return GetInstance(page_id)->FetchPage(page_id);
+}
 
-  // 1. Search the page table for the requested page (P).
-  frame_id_t frame_id;
-  auto it = page_table_.find(page_id);
-  if (it != page_table_.end()) {
-    // 1.1 If P exists, pin it and return it immediately.
-    frame_id = it->second;
-    // pages_[frame_id].pin_count_++;
-    replacer_->Pin(frame_id);
-    return &pages_[frame_id];
-  }
-
-
-  // 1.2 If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  Page *cache_page = nullptr;
-    
-  if (!free_list_.empty()) {  // 如果有页面在空闲列表中
-    frame_id = free_list_.front();
-    cache_page = &pages_[frame_id];
-    free_list_.pop_front();
-  } else {
-    if (replacer_->Victim(&frame_id)) { // 如果空闲列表为空但 replacer_ 有页面可以替换
-        cache_page = &pages_[frame_id];  
-        // 2. If R is dirty, write it back to the disk.
-        if (cache_page->IsDirty()) {
-          disk_manager_->WritePage(cache_page->page_id_, cache_page->data_);
-        }
-        page_table_.erase(cache_page->page_id_);
+/**
+ * 1. 只有从磁盘读入的页才进入 ring，命中的页仍然属于其他访问者
+ * 2. ring 满后，最早进入 ring 的页若未被 pin 且未被修改，则直接归还其所在分片的 free list
+ */
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferRing *ring) {
+  if (ring == nullptr) {
+    return FetchPage(page_id);
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  bool is_miss;
+  Page *page = GetInstance(page_id)->FetchPage(page_id, &is_miss);
+  if (page != nullptr && is_miss) {
+    PushToRing(ring, page_id);
+  }
+  return page;
+}
+
+void BufferPoolManager::PushToRing(BufferRing *ring, page_id_t page_id) {
+  page_id_t discarded = ring->Push(page_id);
+  if (discarded != INVALID_PAGE_ID) {
+    GetInstance(discarded)->DiscardPage(discarded);
+  }
+}
+
+Page *BufferPoolManager::TryFetchPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetInstance(page_id)->TryFetchPage(page_id);
+}
+
+void BufferPoolManager::PrefetchPage(page_id_t page_id, std::shared_ptr<BufferRing> ring) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  lock_guard<mutex> lock(prefetch_latch_);
+  if (prefetch_queue_.size() >= PREFETCH_QUEUE_SIZE) {
+    return;
+  }
+  if (io_workers_.empty()) {
+    for (int i = 0; i < PREFETCH_WORKERS; i++) {
+      io_workers_.emplace_back(&BufferPoolManager::PrefetchWorker, this);
     }
-    else return nullptr;
   }
-  // 3. Delete R from the page table and insert P.
-  page_table_.emplace(page_id, frame_id);
-  // 4. Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  disk_manager_->ReadPage(page_id, pages_[frame_id].data_);
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].is_dirty_ = false;
-  if (pages_[frame_id].pin_count_++ == 0) {
-      replacer_->Pin(frame_id);
+  prefetch_queue_.emplace_back(page_id, std::move(ring));
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::PrefetchWorker() {
+  unique_lock<mutex> lock(prefetch_latch_);
+  vector<page_id_t> page_ids;
+  vector<shared_ptr<BufferRing>> rings;
+  while (true) {
+    prefetch_cv_.wait(lock, [this]() { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    page_ids.clear();
+    rings.clear();
+    while (!prefetch_queue_.empty() && page_ids.size() < PREFETCH_BATCH_PAGES) {
+      page_ids.push_back(prefetch_queue_.front().first);
+      rings.push_back(std::move(prefetch_queue_.front().second));
+      prefetch_queue_.pop_front();
+    }
+    lock.unlock();
+    vector<bool> is_read = PrefetchBatch(page_ids, true);
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      if (is_read[i] && rings[i] != nullptr) {
+        PushToRing(rings[i].get(), page_ids[i]);
+      }
+    }
+    rings.clear();
+    lock.lock();
   }
-  return &pages_[frame_id];
 }
+
 /**
- * TODO: Student Implement
+ * 各分片分别为页预留页框并将读请求加入同一批次，一次提交，完成后再由各分片发布这些页
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  unique_lock<recursive_mutex> lock(latch_);
-
-  // 0. Make sure you call AllocatePage!
-
-  // Pick a victim page P from either the free list or the replacer.
-  frame_id_t frame_id;
-  Page *victim_page = nullptr;
-  if (!free_list_.empty()) {  // 如果有页面在空闲列表中
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-    victim_page = &pages_[frame_id];
-  } 
-  else {
-    if (replacer_->Victim(&frame_id)) {  // 如果空闲列表为空但 replacer_ 有页面可以替换
-      
-      victim_page = &pages_[frame_id];
-      page_table_.erase(victim_page->page_id_);
+vector<bool> BufferPoolManager::PrefetchBatch(const vector<page_id_t> &page_ids, bool may_evict) {
+  vector<bool> is_read(page_ids.size(), false);
+  vector<pair<size_t, BufferPoolManagerInstance::PendingPrefetch>> started;
+  IoBatch batch;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    BufferPoolManagerInstance::PendingPrefetch pending;
+    if (GetInstance(page_ids[i])->StartPrefetch(page_ids[i], may_evict, batch, &pending)) {
+      started.emplace_back(i, pending);
     }
-    else return nullptr;  // If all the pages in the buffer pool are pinned, return nullptr.
-  }
-  // LOG(WARNING) << "victim_page: "<<&pages_[frame_id];
-  // 3. Update P's metadata, zero out memory and add P to the page table.
-  page_id_t new_page_id = AllocatePage();
-  // LOG(WARNING) << "test111" << std::endl;
-  // Page &page = pages_[frame_id];
-  
-  // if (victim_page->is_dirty_) {
-  //   disk_manager_->WritePage(victim_page->page_id_, victim_page->data_);
-  // }
-
-  page_table_.erase(victim_page->page_id_);
-  page_table_.emplace(new_page_id, frame_id); // add P to the page table
-
-  // Update P's metadata
-  page_id = new_page_id;
-  victim_page->page_id_ = new_page_id;
-  victim_page->is_dirty_ = false;
-  victim_page->pin_count_ = 1;
-  memset(victim_page->data_, 0, PAGE_SIZE);
-  replacer_->Pin(frame_id);
-
-  // 4. Set the page ID output parameter. Return a pointer to P.
-  return &pages_[frame_id];
+  }
+  if (started.empty()) {
+    return is_read;
+  }
+  auto start = chrono::steady_clock::now();
+  disk_manager_->SubmitBatch(batch);
+  disk_manager_->WaitBatch(batch);
+  uint64_t io_time_ns =
+      chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count() / started.size();
+  for (auto &entry : started) {
+    GetInstance(page_ids[entry.first])->FinishPrefetch(entry.second, io_time_ns);
+    is_read[entry.first] = true;
+  }
+  return is_read;
 }
 
 /**
- * TODO: Student Implement
+ * 1. 先从磁盘上分配一个逻辑页号，由页号决定该页所属的分片
+ * 2. 若该分片的所有页都被 pin 住，则归还页号，返回 nullptr
  */
-bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  unique_lock<recursive_mutex> lock(latch_);
-
-  // 0. Make sure you call DeallocatePage!
-
+Page *BufferPoolManager::NewPage(page_id_t &page_id, PageSegment *segment) {
+  page_id_t new_page_id = AllocatePage(segment);
+  if (new_page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  Page *page = GetInstance(new_page_id)->NewPage(new_page_id);
+  if (page == nullptr) {
+    DeallocatePage(new_page_id);
+    return nullptr;
+  }
+  page_id = new_page_id;
+  return page;
+}
 
-  // 1. Search the page table for the requested page (P).
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) 
-    return true;
-  
-  // 2. If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  if (pages_[it->second].pin_count_ > 0) 
+bool BufferPoolManager::DeletePage(page_id_t page_id) {
+  if (!GetInstance(page_id)->DeletePage(page_id)) {
     return false;
-
-
-  frame_id_t frame_id = it->second;
-  Page &page = pages_[frame_id];
-  // 3. Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  if (page.IsDirty()) {
-    FlushPage(page_id);
   }
-  page_table_.erase(page_id);
-  page.ResetMemory();
-  page.page_id_ = INVALID_PAGE_ID;
-  page.pin_count_ = 0;
-  page.is_dirty_ = false;
-  free_list_.push_back(frame_id);
   DeallocatePage(page_id);
   return true;
 }
 
-/**
- * TODO: Student Implement
- */
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  unique_lock<recursive_mutex> lock(latch_);
+BasicPageGuard BufferPoolManager::FetchPageBasic(page_id_t page_id) { return {this, FetchPage(page_id)}; }
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->RLatch();
+  }
+  return {this, page};
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->WLatch();
+  }
+  return {this, page};
+}
 
-  // 1. Search the page table for the requested page (P).
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
+BasicPageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id, PageSegment *segment) {
+  return {this, NewPage(page_id, segment)};
+}
+
+bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  if (page_id == INVALID_PAGE_ID) {
     return false;
   }
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
 
-  frame_id_t frame_id = it->second;
-  Page &page = pages_[frame_id];
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
 
-  // 2. If P exists, decrement the pin count. If the pin count is 0, unpin the page.
-  if (page.pin_count_ > 0) {
-    page.pin_count_--;
-    // 3. If the page is dirty, update the page's is_dirty flag.
-    if (is_dirty) {
-      page.is_dirty_ = true;
-    }
-    if (page.pin_count_ == 0) {
-      replacer_->Unpin(frame_id);
+void BufferPoolManager::StartBackgroundWriter(size_t clean_percent, size_t max_pages, uint32_t interval_ms) {
+  if (bg_writer_.joinable()) {
+    return;
+  }
+  bg_stop_ = false;
+  bg_writer_ = thread([this, clean_percent, max_pages, interval_ms]() {
+    auto last_dump = chrono::steady_clock::now();
+    auto last_sync = last_dump;
+    unique_lock<mutex> lock(bg_latch_);
+    while (!bg_cv_.wait_for(lock, chrono::milliseconds(interval_ms), [this]() { return bg_stop_; })) {
+      lock.unlock();
+      WriteBackDirtyPages(max_pages, clean_percent);
+      auto now = chrono::steady_clock::now();
+      if (disk_manager_->GetDurabilityMode() == DurabilityMode::kPeriodic &&
+          now - last_sync >= chrono::milliseconds(SYNC_INTERVAL_MS)) {
+        disk_manager_->Sync();
+        last_sync = now;
+      }
+      if (dump_interval_ms_ > 0 && now - last_dump >= chrono::milliseconds(dump_interval_ms_)) {
+        DumpResidentPages(dump_file_);
+        last_dump = now;
+      }
+      lock.lock();
     }
+  });
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  if (!bg_writer_.joinable()) {
+    return;
+  }
+  {
+    lock_guard<mutex> lock(bg_latch_);
+    bg_stop_ = true;
   }
+  bg_cv_.notify_all();
+  bg_writer_.join();
+}
 
-  return true;
+size_t BufferPoolManager::WriteBackDirtyPages(size_t max_pages, size_t clean_percent) {
+  size_t budget = std::max<size_t>(1, max_pages / instances_.size());
+  size_t num_written = 0;
+  for (auto instance : instances_) {
+    num_written += instance->WriteBackDirtyPages(budget, clean_percent);
+  }
+  return num_written;
+}
 
+void BufferPoolManager::EnableResidentPageDump(const string &file_name, uint32_t interval_ms) {
+  dump_file_ = file_name;
+  dump_interval_ms_ = interval_ms;
 }
 
 /**
- * TODO: Student Implement
+ * 文件格式：magic、页数，随后是页号。各分片的访问时钟互不可比，因此按轮流方式合并各分片的列表，
+ * 使得截断后的前缀在每个分片中都是最近访问的页
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  unique_lock<recursive_mutex> lock(latch_);
+bool BufferPoolManager::DumpResidentPages(const string &file_name) {
+  vector<vector<page_id_t>> lists;
+  size_t total = 0;
+  for (auto instance : instances_) {
+    lists.push_back(instance->GetResidentPages());
+    total += lists.back().size();
+  }
+  vector<page_id_t> page_ids;
+  page_ids.reserve(total);
+  for (size_t i = 0; page_ids.size() < total; i++) {
+    for (auto &list : lists) {
+      if (i < list.size()) {
+        page_ids.push_back(list[i]);
+      }
+    }
+  }
+  const string tmp_file_name = file_name + ".tmp";
+  {
+    ofstream out(tmp_file_name, ios::binary | ios::trunc);
+    uint32_t header[2] = {RESIDENT_PAGES_DUMP_MAGIC, static_cast<uint32_t>(page_ids.size())};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+    if (!out.good()) {
+      LOG(WARNING) << "Failed to dump the resident pages to " << tmp_file_name;
+      return false;
+    }
+  }
+  return rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+}
 
-  // LOG(WARNING) << "CheckAllUnpinned: " << CheckAllUnpinned();
-  // 1. Search the page table for the requested page (P).
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
-    return false;
+size_t BufferPoolManager::LoadResidentPages(const string &file_name) {
+  ifstream in(file_name, ios::binary);
+  uint32_t header[2];
+  if (!in.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != RESIDENT_PAGES_DUMP_MAGIC) {
+    return 0;
+  }
+  // The count comes from the file, check it against the file size before trusting it.
+  auto body_begin = in.tellg();
+  in.seekg(0, ios::end);
+  auto body_size = static_cast<uint64_t>(in.tellg() - body_begin);
+  in.seekg(body_begin);
+  if (static_cast<uint64_t>(header[1]) * sizeof(page_id_t) > body_size) {
+    LOG(WARNING) << "Ignoring truncated buffer pool dump " << file_name;
+    return 0;
+  }
+  // The pool may have shrunk since the dump, keep the most recently used pages only.
+  vector<page_id_t> page_ids(std::min<size_t>(header[1], pool_size_));
+  if (!in.read(reinterpret_cast<char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t))) {
+    LOG(WARNING) << "Ignoring truncated buffer pool dump " << file_name;
+    return 0;
   }
+  sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(unique(page_ids.begin(), page_ids.end()), page_ids.end());
+  size_t num_pages = page_ids.size();
+  StopWarmup();
+  warmup_stop_ = false;
+  warmup_ = thread(&BufferPoolManager::WarmUp, this, std::move(page_ids));
+  return num_pages;
+}
 
-  // 2. If P exists, write its contents to disk.
-  
-  LOG(WARNING) << "page_id: " << page_id;
-  disk_manager_->WritePage(page_id, pages_[it->second].data_);
-  pages_[it->second].is_dirty_ = false;
+/**
+ * 按页号顺序分批读入，每批作为一个 I/O 批次提交，使磁盘访问尽量连续；每批之间检查是否需要停止
+ */
+void BufferPoolManager::WarmUp(vector<page_id_t> page_ids) {
+  vector<page_id_t> batch;
+  for (size_t begin = 0; begin < page_ids.size(); begin += WARMUP_BATCH_PAGES) {
+    if (warmup_stop_) {
+      return;
+    }
+    size_t end = std::min(page_ids.size(), begin + WARMUP_BATCH_PAGES);
+    batch.clear();
+    for (size_t i = begin; i < end; i++) {
+      if (page_ids[i] >= 0 && !IsPageFree(page_ids[i])) {
+        batch.push_back(page_ids[i]);
+      }
+    }
+    PrefetchBatch(batch, false);
+  }
+}
 
-  return true;
+void BufferPoolManager::StopWarmup() {
+  if (!warmup_.joinable()) {
+    return;
+  }
+  warmup_stop_ = true;
+  warmup_.join();
 }
 
-page_id_t BufferPoolManager::AllocatePage() {
-  int next_page_id = disk_manager_->AllocatePage();
+page_id_t BufferPoolManager::AllocatePage(PageSegment *segment) {
+  int next_page_id = disk_manager_->AllocatePage(segment);
   return next_page_id;
 }
 
@@ -224,18 +379,33 @@ void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id
   disk_manager_->DeAllocatePage(page_id);
 }
 
+void BufferPoolManager::FlushAllPages() {
+  for (auto instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
 bool BufferPoolManager::IsPageFree(page_id_t page_id) {
   return disk_manager_->IsPageFree(page_id);
 }
 
+BufferPoolStats BufferPoolManager::GetStats() const {
+  BufferPoolStats stats;
+  for (auto instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+BufferPoolStats BufferPoolManager::GetInstanceStats(size_t instance_index) const {
+  return instances_[instance_index]->GetStats();
+}
+
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
   bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
-      res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
-    }
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
   }
   return res;
-}
\ No newline at end of file
+}
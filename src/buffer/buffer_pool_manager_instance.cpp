@@ -0,0 +1,499 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "glog/logging.h"
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      frames_(pool_size),
+      pages_(frames_.GetPages()),
+      disk_manager_(disk_manager),
+      last_access_(pool_size, 0) {
+  replacer_ = Replacer::Create(replacer_type, pool_size_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    free_list_.emplace_back(i);
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  FlushAllPages();
+  delete replacer_;
+}
+
+/**
+ * Fetches a page from this instance.
+ *
+ * @param page_id The ID of the page to fetch.
+ * @param[out] is_miss Set to whether the page had to be read from disk.
+ * @return A pointer to the fetched page, or nullptr if all pages in this instance are pinned.
+ */
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id, bool *is_miss) {
+  unique_lock<mutex> lock(latch_);
+  Count(BufferPoolStats::kFetches);
+  if (is_miss != nullptr) {
+    *is_miss = false;
+  }
+  // 1. Search the page table for the requested page (P).
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) {
+    // Do not read P from disk while an older copy of it is still being written.
+    WaitForWriteBack(page_id, lock);
+    it = page_table_.find(page_id);
+  }
+  if (it != page_table_.end()) {
+    // 1.1 If P exists, pin it and return it once its content is in memory.
+    Page &page = pages_[it->second];
+    page.pin_count_++;
+    replacer_->Pin(it->second);
+    last_access_[it->second] = ++access_clock_;
+    Count(BufferPoolStats::kHits);
+    WaitForIo(lock, [&page]() { return !page.io_in_progress_; });
+    return &page;
+  }
+  // 1.2 If P does not exist, find a replacement page (R) from either the free list or the replacer.
+  frame_id_t frame_id;
+  page_id_t dirty_page_id;
+  if (!TryToFindFreeFrame(&frame_id, &dirty_page_id)) {
+    return nullptr;
+  }
+  if (is_miss != nullptr) {
+    *is_miss = true;
+  }
+  Count(BufferPoolStats::kMisses);
+  // 2. Reserve the frame for P, so that other requests of P wait for this read instead of issuing their own.
+  Page &page = pages_[frame_id];
+  page_table_.emplace(page_id, frame_id);
+  page.page_id_ = page_id;
+  page.is_dirty_ = false;
+  page.pin_count_ = 1;
+  page.io_in_progress_ = true;
+  replacer_->Pin(frame_id);
+  last_access_[frame_id] = ++access_clock_;
+  lock.unlock();
+  // 3. If R is dirty, write it back, then read in the content of P, both without holding the latch and as one batch.
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    IoBatch batch;
+    disk_manager_->WritePageAsync(batch, dirty_page_id, page.data_);
+    batch.LinkLast();
+    disk_manager_->ReadPageAsync(batch, page_id, page.data_);
+    RunBatch(batch);
+  } else {
+    ReadFromDisk(page_id, page.data_);
+  }
+  lock.lock();
+  FinishIo(page, dirty_page_id);
+  return &page;
+}
+
+Page *BufferPoolManagerInstance::TryFetchPage(page_id_t page_id) {
+  lock_guard<mutex> lock(latch_);
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end() || pages_[it->second].io_in_progress_) {
+    return nullptr;
+  }
+  Page &page = pages_[it->second];
+  page.pin_count_++;
+  replacer_->Pin(it->second);
+  last_access_[it->second] = ++access_clock_;
+  return &page;
+}
+
+bool BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, bool may_evict) {
+  IoBatch batch;
+  PendingPrefetch pending;
+  if (!StartPrefetch(page_id, may_evict, batch, &pending)) {
+    return false;
+  }
+  auto start = chrono::steady_clock::now();
+  disk_manager_->SubmitBatch(batch);
+  disk_manager_->WaitBatch(batch);
+  FinishPrefetch(pending, ElapsedNs(start));
+  return true;
+}
+
+bool BufferPoolManagerInstance::StartPrefetch(page_id_t page_id, bool may_evict, IoBatch &batch,
+                                              PendingPrefetch *pending) {
+  unique_lock<mutex> lock(latch_);
+  // Never block: the write-back of the page may be queued in the very batch of the caller, not submitted yet.
+  if (page_table_.find(page_id) != page_table_.end() || writing_pages_.find(page_id) != writing_pages_.end()) {
+    return false;
+  }
+  frame_id_t frame_id;
+  page_id_t dirty_page_id;
+  if ((!may_evict && free_list_.empty()) || !TryToFindFreeFrame(&frame_id, &dirty_page_id)) {
+    return false;
+  }
+  // Same as a miss in FetchPage, except that the page is not an access of its own: it enters the replacer through
+  // Unpin only, once the read is done.
+  Page &page = pages_[frame_id];
+  page_table_.emplace(page_id, frame_id);
+  page.page_id_ = page_id;
+  page.is_dirty_ = false;
+  page.pin_count_ = 1;
+  page.io_in_progress_ = true;
+  last_access_[frame_id] = 0;
+  lock.unlock();
+  Count(BufferPoolStats::kPrefetches);
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePageAsync(batch, dirty_page_id, page.data_);
+    batch.LinkLast();
+  }
+  disk_manager_->ReadPageAsync(batch, page_id, page.data_);
+  pending->frame_id = frame_id;
+  pending->dirty_page_id = dirty_page_id;
+  return true;
+}
+
+void BufferPoolManagerInstance::FinishPrefetch(const PendingPrefetch &pending, uint64_t io_time_ns) {
+  Count(BufferPoolStats::kDiskReads);
+  Count(BufferPoolStats::kReadTimeNs, io_time_ns);
+  if (pending.dirty_page_id != INVALID_PAGE_ID) {
+    Count(BufferPoolStats::kDiskWrites);
+  }
+  lock_guard<mutex> lock(latch_);
+  Page &page = pages_[pending.frame_id];
+  FinishIo(page, pending.dirty_page_id);
+  if (--page.pin_count_ == 0) {
+    replacer_->Unpin(pending.frame_id);
+  }
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t page_id) {
+  unique_lock<mutex> lock(latch_);
+  WaitForWriteBack(page_id, lock);
+  // Pick a victim page P from either the free list or the replacer.
+  frame_id_t frame_id;
+  page_id_t dirty_page_id;
+  if (!TryToFindFreeFrame(&frame_id, &dirty_page_id)) {
+    return nullptr;  // If all the pages in the buffer pool are pinned, return nullptr.
+  }
+  // Update P's metadata and add P to the page table.
+  Page &page = pages_[frame_id];
+  page_table_.emplace(page_id, frame_id);
+  page.page_id_ = page_id;
+  page.is_dirty_ = false;
+  page.pin_count_ = 1;
+  replacer_->Pin(frame_id);
+  last_access_[frame_id] = ++access_clock_;
+  Count(BufferPoolStats::kNewPages);
+  if (dirty_page_id == INVALID_PAGE_ID) {
+    page.ResetMemory();
+    return &page;
+  }
+  // The frame still holds the dirty victim, write it back without the latch before zeroing out the memory.
+  page.io_in_progress_ = true;
+  lock.unlock();
+  WriteToDisk(dirty_page_id, page.data_);
+  page.ResetMemory();
+  lock.lock();
+  FinishIo(page, dirty_page_id);
+  return &page;
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  lock_guard<mutex> lock(latch_);
+  // 1. Search the page table for the requested page (P).
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) {
+    Count(BufferPoolStats::kDeletedPages);
+    return true;
+  }
+  // 2. If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  frame_id_t frame_id = it->second;
+  Page &page = pages_[frame_id];
+  if (page.pin_count_ > 0) {
+    return false;
+  }
+  // 3. Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  page_table_.erase(it);
+  replacer_->Remove(frame_id);
+  page.ResetMemory();
+  page.page_id_ = INVALID_PAGE_ID;
+  page.pin_count_ = 0;
+  page.is_dirty_ = false;
+  free_list_.push_back(frame_id);
+  Count(BufferPoolStats::kDeletedPages);
+  return true;
+}
+
+bool BufferPoolManagerInstance::DiscardPage(page_id_t page_id) {
+  lock_guard<mutex> lock(latch_);
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) {
+    return false;
+  }
+  frame_id_t frame_id = it->second;
+  Page &page = pages_[frame_id];
+  if (page.pin_count_ > 0 || page.is_dirty_) {
+    return false;
+  }
+  page_table_.erase(it);
+  replacer_->Remove(frame_id);
+  page.page_id_ = INVALID_PAGE_ID;
+  free_list_.push_back(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  lock_guard<mutex> lock(latch_);
+  // 1. Search the page table for the requested page (P).
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) {
+    return false;
+  }
+  frame_id_t frame_id = it->second;
+  Page &page = pages_[frame_id];
+  // 2. If P exists, decrement the pin count. If the pin count is 0, unpin the page.
+  if (page.pin_count_ > 0) {
+    page.pin_count_--;
+    // 3. If the page is dirty, update the page's is_dirty flag.
+    if (is_dirty) {
+      page.is_dirty_ = true;
+    }
+    if (page.pin_count_ == 0) {
+      replacer_->Unpin(frame_id);
+    }
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  unique_lock<mutex> lock(latch_);
+  return FlushPageImpl(page_id, lock);
+}
+
+void BufferPoolManagerInstance::FlushAllPages() {
+  unique_lock<mutex> lock(latch_);
+  // 1. Wait for the write-backs already in flight, of dirty victims as well, so that the caller may sync the file.
+  vector<page_id_t> in_flight(writing_pages_.begin(), writing_pages_.end());
+  for (auto page_id : in_flight) {
+    WaitForWriteBack(page_id, lock);
+  }
+  // 2. Collect the dirty pages. One still being written back was dirtied again, wait for the older copy and retry.
+  vector<pair<page_id_t, frame_id_t>> dirty_pages;
+  while (true) {
+    dirty_pages.clear();
+    page_id_t busy_page_id = INVALID_PAGE_ID;
+    for (auto &entry : page_table_) {
+      Page &page = pages_[entry.second];
+      if (!page.is_dirty_ || page.io_in_progress_) {
+        continue;
+      }
+      if (writing_pages_.find(entry.first) != writing_pages_.end()) {
+        busy_page_id = entry.first;
+        break;
+      }
+      dirty_pages.emplace_back(entry.first, entry.second);
+    }
+    if (busy_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    WaitForWriteBack(busy_page_id, lock);
+  }
+  // 3. Write them as one batch without the latch.
+  sort(dirty_pages.begin(), dirty_pages.end());
+  WriteCopies(dirty_pages, lock);
+  Count(BufferPoolStats::kFlushes, dirty_pages.size());
+}
+
+bool BufferPoolManagerInstance::FlushPageImpl(page_id_t page_id, unique_lock<mutex> &lock) {
+  while (true) {
+    // 1. Wait for a pending write-back of the requested page (P), then search the page table for it.
+    WaitForWriteBack(page_id, lock);
+    auto it = page_table_.find(page_id);
+    if (it == page_table_.end()) {
+      return false;
+    }
+    // 2. If P exists and is in memory, write its contents to disk unless it is clean. Otherwise wait for the read and
+    //    search again.
+    Page &page = pages_[it->second];
+    if (!page.io_in_progress_) {
+      if (page.is_dirty_) {
+        WriteCopies({{page_id, it->second}}, lock);
+        Count(BufferPoolStats::kFlushes);
+      }
+      return true;
+    }
+    WaitForIo(lock, [&page]() { return !page.io_in_progress_; });
+  }
+}
+
+size_t BufferPoolManagerInstance::WriteBackDirtyPages(size_t max_pages, size_t clean_percent) {
+  unique_lock<mutex> lock(latch_);
+  // 1. Collect the dirty pages which can be written back, in page id order.
+  size_t num_dirty = 0;
+  vector<pair<page_id_t, frame_id_t>> candidates;
+  for (auto &entry : page_table_) {
+    Page &page = pages_[entry.second];
+    if (!page.is_dirty_) {
+      continue;
+    }
+    num_dirty++;
+    if (page.pin_count_ == 0 && !page.io_in_progress_ && writing_pages_.find(entry.first) == writing_pages_.end()) {
+      candidates.emplace_back(entry.first, entry.second);
+    }
+  }
+  size_t max_dirty = pool_size_ * (100 - min<size_t>(clean_percent, 100)) / 100;
+  if (num_dirty <= max_dirty || candidates.empty()) {
+    return 0;
+  }
+  size_t num_pages = min({num_dirty - max_dirty, max_pages, candidates.size()});
+  sort(candidates.begin(), candidates.end());
+  candidates.resize(num_pages);
+  // 2. Write them without the latch, all of them in flight at once.
+  WriteCopies(candidates, lock);
+  Count(BufferPoolStats::kBgWrites, num_pages);
+  return num_pages;
+}
+
+void BufferPoolManagerInstance::WriteCopies(const vector<pair<page_id_t, frame_id_t>> &pages,
+                                            unique_lock<mutex> &lock) {
+  if (pages.empty()) {
+    return;
+  }
+  // 1. Take a copy of every page and mark it clean, a later modification dirties it again. The copies are aligned as
+  //    the frames are, for O_DIRECT.
+  size_t num_pages = pages.size();
+  unique_ptr<char, decltype(&free)> copies(static_cast<char *>(aligned_alloc(PAGE_SIZE, num_pages * PAGE_SIZE)),
+                                           &free);
+  for (size_t i = 0; i < num_pages; i++) {
+    Page &page = pages_[pages[i].second];
+    memcpy(copies.get() + i * PAGE_SIZE, page.data_, PAGE_SIZE);
+    page.is_dirty_ = false;
+    writing_pages_.insert(pages[i].first);
+  }
+  // 2. Write the copies as one batch without the latch.
+  lock.unlock();
+  IoBatch batch;
+  for (size_t i = 0; i < num_pages; i++) {
+    disk_manager_->WritePageAsync(batch, pages[i].first, copies.get() + i * PAGE_SIZE);
+  }
+  RunBatch(batch);
+  lock.lock();
+  for (auto &page : pages) {
+    writing_pages_.erase(page.first);
+  }
+  io_cv_.notify_all();
+}
+
+bool BufferPoolManagerInstance::TryToFindFreeFrame(frame_id_t *frame_id, page_id_t *dirty_page_id) {
+  *dirty_page_id = INVALID_PAGE_ID;
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  // A victim dirtied again while the background writer writes an older copy of it cannot be written back now, put
+  // such victims back into the replacer after the choice.
+  vector<frame_id_t> skipped;
+  bool found = false;
+  while (replacer_->Victim(frame_id)) {
+    Page &victim = pages_[*frame_id];
+    if (victim.IsDirty() && writing_pages_.find(victim.page_id_) != writing_pages_.end()) {
+      skipped.push_back(*frame_id);
+      continue;
+    }
+    found = true;
+    break;
+  }
+  for (auto skipped_frame_id : skipped) {
+    replacer_->Unpin(skipped_frame_id);
+  }
+  if (!found) {
+    return false;
+  }
+  // If the victim R is dirty, the caller writes it back before reusing the frame.
+  Page &victim = pages_[*frame_id];
+  Count(BufferPoolStats::kEvictions);
+  if (victim.IsDirty()) {
+    Count(BufferPoolStats::kDirtyEvictions);
+    *dirty_page_id = victim.page_id_;
+    writing_pages_.insert(victim.page_id_);
+  }
+  page_table_.erase(victim.page_id_);
+  return true;
+}
+
+void BufferPoolManagerInstance::WaitForWriteBack(page_id_t page_id, unique_lock<mutex> &lock) {
+  WaitForIo(lock, [this, page_id]() { return writing_pages_.find(page_id) == writing_pages_.end(); });
+}
+
+void BufferPoolManagerInstance::FinishIo(Page &page, page_id_t dirty_page_id) {
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    writing_pages_.erase(dirty_page_id);
+  }
+  page.io_in_progress_ = false;
+  io_cv_.notify_all();
+}
+
+vector<page_id_t> BufferPoolManagerInstance::GetResidentPages() {
+  vector<pair<uint64_t, page_id_t>> resident;
+  {
+    lock_guard<mutex> lock(latch_);
+    resident.reserve(page_table_.size());
+    for (auto &entry : page_table_) {
+      if (!pages_[entry.second].io_in_progress_) {
+        resident.emplace_back(last_access_[entry.second], entry.first);
+      }
+    }
+  }
+  sort(resident.begin(), resident.end(), greater<>());
+  vector<page_id_t> page_ids;
+  page_ids.reserve(resident.size());
+  for (auto &entry : resident) {
+    page_ids.push_back(entry.second);
+  }
+  return page_ids;
+}
+
+BufferPoolStats BufferPoolManagerInstance::GetStats() const {
+  BufferPoolStats stats;
+  for (size_t i = 0; i < BufferPoolStats::kNumCounters; i++) {
+    stats.Set(static_cast<BufferPoolStats::Counter>(i), counters_[i].load(memory_order_relaxed));
+  }
+  return stats;
+}
+
+void BufferPoolManagerInstance::ReadFromDisk(page_id_t page_id, char *page_data) {
+  auto start = chrono::steady_clock::now();
+  disk_manager_->ReadPage(page_id, page_data);
+  Count(BufferPoolStats::kReadTimeNs, ElapsedNs(start));
+  Count(BufferPoolStats::kDiskReads);
+}
+
+void BufferPoolManagerInstance::WriteToDisk(page_id_t page_id, const char *page_data) {
+  auto start = chrono::steady_clock::now();
+  disk_manager_->WritePage(page_id, page_data);
+  Count(BufferPoolStats::kWriteTimeNs, ElapsedNs(start));
+  Count(BufferPoolStats::kDiskWrites);
+}
+
+void BufferPoolManagerInstance::RunBatch(IoBatch &batch) {
+  auto start = chrono::steady_clock::now();
+  disk_manager_->SubmitBatch(batch);
+  disk_manager_->WaitBatch(batch);
+  size_t num_writes = batch.NumWrites();
+  size_t num_reads = batch.Size() - num_writes;
+  Count(num_reads > 0 ? BufferPoolStats::kReadTimeNs : BufferPoolStats::kWriteTimeNs, ElapsedNs(start));
+  Count(BufferPoolStats::kDiskReads, num_reads);
+  Count(BufferPoolStats::kDiskWrites, num_writes);
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckAllUnpinned() {
+  lock_guard<mutex> lock(latch_);
+  bool res = true;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (pages_[i].pin_count_ != 0) {
+      res = false;
+      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
+    }
+  }
+  return res;
+}
@@ -0,0 +1,34 @@
+#include "buffer/buffer_pool_stats.h"
+
+const char *BufferPoolStats::GetName(Counter counter) {
+  static const char *names[kNumCounters] = {"Buffer_pool_fetches",
+                                             "Buffer_pool_hits",
+                                             "Buffer_pool_misses",
+                                             "Buffer_pool_prefetches",
+                                             "Buffer_pool_evictions",
+                                             "Buffer_pool_dirty_evictions",
+                                             "Buffer_pool_flushes",
+                                             "Buffer_pool_bgwriter_writes",
+                                             "Buffer_pool_new_pages",
+                                             "Buffer_pool_deleted_pages",
+                                             "Buffer_pool_disk_reads",
+                                             "Buffer_pool_disk_writes",
+                                             "Buffer_pool_read_time_ns",
+                                             "Buffer_pool_write_time_ns",
+                                             "Buffer_pool_io_wait_time_ns"};
+  return counter < kNumCounters ? names[counter] : "unknown";
+}
+
+double BufferPoolStats::HitRatio() const {
+  if (values_[kFetches] == 0) {
+    return 0;
+  }
+  return static_cast<double>(values_[kHits]) / static_cast<double>(values_[kFetches]);
+}
+
+BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &that) {
+  for (size_t i = 0; i < kNumCounters; i++) {
+    values_[i] += that.values_[i];
+  }
+  return *this;
+}
@@ -0,0 +1,14 @@
+#include "buffer/buffer_ring.h"
+
+BufferRing::BufferRing(size_t ring_size) : ring_size_(ring_size) {}
+
+page_id_t BufferRing::Push(page_id_t page_id) {
+  lock_guard<mutex> guard(latch_);
+  pages_.push_back(page_id);
+  if (pages_.size() <= ring_size_) {
+    return INVALID_PAGE_ID;
+  }
+  page_id_t oldest = pages_.front();
+  pages_.pop_front();
+  return oldest;
+}
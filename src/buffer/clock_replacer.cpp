@@ -0,0 +1,51 @@
+#include "buffer/clock_replacer.h"
+
+CLOCKReplacer::CLOCKReplacer(size_t num_pages)
+    : capacity(num_pages), in_replacer_(num_pages, false), ref_bits_(num_pages, false) {}
+
+CLOCKReplacer::~CLOCKReplacer() = default;
+
+/**
+ * 从时钟指针开始扫描，访问位为 1 的数据页获得第二次机会，遇到访问位为 0 的数据页即为 victim
+ * 至多扫描两圈
+ */
+bool CLOCKReplacer::Victim(frame_id_t *frame_id) {
+  if (size_ == 0) {
+    return false;
+  }
+  while (true) {
+    size_t current = hand_;
+    hand_ = (hand_ + 1) % capacity;
+    if (!in_replacer_[current]) {
+      continue;
+    }
+    if (ref_bits_[current]) {
+      ref_bits_[current] = false;
+      continue;
+    }
+    in_replacer_[current] = false;
+    size_--;
+    *frame_id = static_cast<frame_id_t>(current);
+    return true;
+  }
+}
+
+void CLOCKReplacer::Pin(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) < capacity && in_replacer_[frame_id]) {
+    in_replacer_[frame_id] = false;
+    size_--;
+  }
+}
+
+void CLOCKReplacer::Unpin(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= capacity || in_replacer_[frame_id]) {
+    return;
+  }
+  in_replacer_[frame_id] = true;
+  ref_bits_[frame_id] = true;
+  size_++;
+}
+
+size_t CLOCKReplacer::Size() {
+  return size_;
+}
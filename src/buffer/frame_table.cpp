@@ -0,0 +1,60 @@
+#include "buffer/frame_table.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <new>
+
+#include "glog/logging.h"
+
+/**
+ * 1. 数据区不小于一个大页时，按大页对齐并向上取整
+ * 2. 配置了 BUFFER_POOL_HUGETLB 时先尝试预留大页，失败（如系统没有足够的大页）则使用普通匿名映射
+ * 3. 普通匿名映射多映射一个大页用于对齐，再通过 madvise 请求透明大页
+ */
+FrameTable::FrameTable(size_t num_frames) : num_frames_(num_frames) {
+  size_t data_size = num_frames_ * PAGE_SIZE;
+  bool huge = data_size >= HUGE_PAGE_SIZE;
+  if (huge) {
+    data_size = (data_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+  mapping_ = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (huge && BUFFER_POOL_HUGETLB) {
+    mapping_ = mmap(nullptr, data_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapping_ == MAP_FAILED) {
+      LOG(WARNING) << "Not enough huge pages for the buffer pool, using transparent huge pages";
+    } else {
+      huge_tlb_ = true;
+      mapping_size_ = data_size;
+      data_ = static_cast<char *>(mapping_);
+    }
+  }
+#endif
+  if (mapping_ == MAP_FAILED) {
+    mapping_size_ = huge ? data_size + HUGE_PAGE_SIZE : data_size;
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping_ == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    auto start = reinterpret_cast<uintptr_t>(mapping_);
+    data_ = reinterpret_cast<char *>(huge ? (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE : start);
+#ifdef MADV_HUGEPAGE
+    if (huge) {
+      madvise(data_, data_size, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  pages_ = static_cast<Page *>(::operator new(num_frames_ * sizeof(Page)));
+  for (size_t i = 0; i < num_frames_; i++) {
+    new (&pages_[i]) Page(data_ + i * PAGE_SIZE, false);
+  }
+}
+
+FrameTable::~FrameTable() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete(pages_);
+  munmap(mapping_, mapping_size_);
+}
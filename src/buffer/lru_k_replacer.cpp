@@ -0,0 +1,82 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period)
+    : max_pages_(num_pages),
+      k_(k),
+      correlated_period_(correlated_period),
+      history_(num_pages * k, 0),
+      access_count_(num_pages, 0),
+      last_access_(num_pages, 0),
+      in_replacer_(num_pages, false) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  if (evictable_.empty()) {
+    return false;
+  }
+  *frame_id = get<2>(*evictable_.begin());
+  evictable_.erase(evictable_.begin());
+  in_replacer_[*frame_id] = false;
+  // The frame will hold another page, forget the references of the evicted one.
+  access_count_[*frame_id] = 0;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= max_pages_) {
+    return;
+  }
+  if (in_replacer_[frame_id]) {
+    evictable_.erase(GetKey(frame_id));
+    in_replacer_[frame_id] = false;
+  }
+  RecordAccess(frame_id);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= max_pages_ || in_replacer_[frame_id]) {
+    return;
+  }
+  if (access_count_[frame_id] == 0) {
+    RecordAccess(frame_id);
+  }
+  in_replacer_[frame_id] = true;
+  evictable_.insert(GetKey(frame_id));
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= max_pages_) {
+    return;
+  }
+  if (in_replacer_[frame_id]) {
+    evictable_.erase(GetKey(frame_id));
+    in_replacer_[frame_id] = false;
+  }
+  access_count_[frame_id] = 0;
+}
+
+size_t LRUKReplacer::Size() {
+  return evictable_.size();
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  uint64_t now = ++current_tick_;
+  size_t &count = access_count_[frame_id];
+  if (count > 0 && now - last_access_[frame_id] < correlated_period_) {
+    last_access_[frame_id] = now;
+    return;
+  }
+  history_[frame_id * k_ + count % k_] = now;
+  count++;
+  last_access_[frame_id] = now;
+}
+
+LRUKReplacer::Key LRUKReplacer::GetKey(frame_id_t frame_id) const {
+  size_t count = access_count_[frame_id];
+  if (count < k_) {
+    return Key(false, history_[frame_id * k_], frame_id);
+  }
+  // The slot to be overwritten by the next reference holds the K-th most recent one.
+  return Key(true, history_[frame_id * k_ + count % k_], frame_id);
+}
@@ -1,6 +1,11 @@
 #include "buffer/lru_replacer.h"
 
-LRUReplacer::LRUReplacer(size_t num_pages) : max_pages_(num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages)
+    : max_pages_(num_pages), prev_(num_pages + 1), next_(num_pages + 1), in_list_(num_pages, false) {
+  frame_id_t head = static_cast<frame_id_t>(max_pages_);
+  prev_[head] = head;
+  next_[head] = head;
+}
 
 LRUReplacer::~LRUReplacer() = default;
 
@@ -8,26 +13,20 @@ LRUReplacer::~LRUReplacer() = default;
  * DONE
  */
 bool LRUReplacer::Victim(frame_id_t *frame_id) {
-  lock_guard<mutex> guard(latch_);
-  if (lru_list_.empty()) {
+  if (size_ == 0) {
     return false;
   }
-  *frame_id = lru_list_.back();
-  lru_list_.pop_back();
-  frame_set_.erase(*frame_id);
+  *frame_id = prev_[max_pages_];
+  Unlink(*frame_id);
   return true;
 }
 
-
 /**
  * DONE
  */
 void LRUReplacer::Pin(frame_id_t frame_id) {
-  lock_guard<mutex> guard(latch_);
-  auto it = frame_set_.find(frame_id);
-  if (it != frame_set_.end()) {
-    lru_list_.remove(frame_id); // Since std::list does not support fast remove, this operation is O(n)
-    frame_set_.erase(it);
+  if (static_cast<size_t>(frame_id) < max_pages_ && in_list_[frame_id]) {
+    Unlink(frame_id);
   }
 }
 
@@ -35,10 +34,21 @@ void LRUReplacer::Pin(frame_id_t frame_id) {
  * DONE
  */
 void LRUReplacer::Unpin(frame_id_t frame_id) {
-  lock_guard<mutex> guard(latch_);
-  if (frame_set_.find(frame_id) == frame_set_.end()) {
-    lru_list_.push_front(frame_id);
-    frame_set_.insert(frame_id);
+  if (static_cast<size_t>(frame_id) >= max_pages_ || in_list_[frame_id]) {
+    return;
+  }
+  frame_id_t head = static_cast<frame_id_t>(max_pages_);
+  prev_[frame_id] = head;
+  next_[frame_id] = next_[head];
+  prev_[next_[head]] = frame_id;
+  next_[head] = frame_id;
+  in_list_[frame_id] = true;
+  size_++;
+}
+
+void LRUReplacer::Remove(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) < max_pages_ && in_list_[frame_id]) {
+    Unlink(frame_id);
   }
 }
 
@@ -46,12 +56,12 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
  * DONE
  */
 size_t LRUReplacer::Size() {
-  lock_guard<mutex> guard(latch_);
-  return frame_set_.size();
+  return size_;
 }
 
-
-
-
-
-
+void LRUReplacer::Unlink(frame_id_t frame_id) {
+  next_[prev_[frame_id]] = next_[frame_id];
+  prev_[next_[frame_id]] = prev_[frame_id];
+  in_list_[frame_id] = false;
+  size_--;
+}
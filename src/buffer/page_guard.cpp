@@ -0,0 +1,89 @@
+#include "buffer/page_guard.h"
+
+#include "buffer/buffer_pool_manager.h"
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+BasicPageGuard &BasicPageGuard::operator=(BasicPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.bpm_ = nullptr;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+  }
+  return *this;
+}
+
+BasicPageGuard::~BasicPageGuard() { Drop(); }
+
+void BasicPageGuard::Drop() {
+  if (page_ != nullptr) {
+    bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  }
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+ReadPageGuard BasicPageGuard::UpgradeRead() {
+  if (page_ != nullptr) {
+    page_->RLatch();
+  }
+  ReadPageGuard guard;
+  guard.guard_ = std::move(*this);
+  return guard;
+}
+
+WritePageGuard BasicPageGuard::UpgradeWrite() {
+  if (page_ != nullptr) {
+    page_->WLatch();
+  }
+  WritePageGuard guard;
+  guard.guard_ = std::move(*this);
+  return guard;
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+ReadPageGuard::~ReadPageGuard() { Drop(); }
+
+/**
+ * 先释放读锁再 unpin，unpin 之后页框可能被替换给其他页
+ */
+void ReadPageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->RUnlatch();
+  }
+  guard_.Drop();
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+WritePageGuard::~WritePageGuard() { Drop(); }
+
+void WritePageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->WUnlatch();
+  }
+  guard_.Drop();
+}
@@ -1,7 +1,7 @@
 #include "catalog/catalog.h"
 
 void CatalogMeta::SerializeTo(char *buf) const {
-  ASSERT(GetSerializedSize() <= PAGE_SIZE, "Failed to serialize catalog metadata to disk.");
+  ASSERT(GetSerializedSize() <= PAGE_USABLE_SIZE, "Failed to serialize catalog metadata to disk.");
   MACH_WRITE_UINT32(buf, CATALOG_METADATA_MAGIC_NUM);
   buf += 4;
   MACH_WRITE_UINT32(buf, table_meta_pages_.size());
@@ -22,7 +22,7 @@ void CatalogMeta::SerializeTo(char *buf) const {
   }
 }
 
-CatalogMeta *CatalogMeta::DeserializeFrom(char *buf) {
+CatalogMeta *CatalogMeta::DeserializeFrom(const char *buf) {
   // check valid
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
@@ -79,14 +79,15 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
                                LogManager *log_manager, bool init)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
   if (!init) {                                                                 // 如果不是初次创建
-    auto catalog_page = buffer_pool_manager->FetchPage(CATALOG_META_PAGE_ID);  // 获取页面以获取CatalogMeta的信息
-    catalog_meta_ = CatalogMeta::DeserializeFrom(reinterpret_cast<char *>(catalog_page->GetData()));
+    auto catalog_guard = buffer_pool_manager->FetchPageBasic(CATALOG_META_PAGE_ID);  // 获取页面以获取CatalogMeta的信息
+    catalog_meta_ = CatalogMeta::DeserializeFrom(catalog_guard.GetData());
+    catalog_guard.Drop();
     next_index_id_ = catalog_meta_->GetNextIndexId();                     // 赋值私有变量next_index_id_
     next_table_id_ = catalog_meta_->GetNextTableId();                     // 赋值私有变量next_table_id_
     for (auto it : catalog_meta_->table_meta_pages_) {                    // 获取所有表的元信息的目录
-      auto table_meta_page = buffer_pool_manager_->FetchPage(it.second);  // 获取该表元信息所在的页
+      auto table_meta_guard = buffer_pool_manager_->FetchPageBasic(it.second);  // 获取该表元信息所在的页
       TableMetadata *table_meta;
-      TableMetadata::DeserializeFrom(table_meta_page->GetData(), table_meta);  // 将表的元信息反序列化出来
+      TableMetadata::DeserializeFrom(table_meta_guard.GetData(), table_meta);  // 将表的元信息反序列化出来
       table_names_[table_meta->GetTableName()] = table_meta->GetTableId();     // 获取表的名字
       // 根据已有信息创建一个堆表
       auto table_heap = TableHeap::Create(buffer_pool_manager, table_meta->GetFirstPageId(), table_meta->GetSchema(),
@@ -99,9 +100,9 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
       }
     }
     for (auto it : catalog_meta_->index_meta_pages_) {                    // 获取所有索引的元信息的目录
-      auto index_meta_page = buffer_pool_manager_->FetchPage(it.second);  // 获取该索引元信息所在的页
+      auto index_meta_guard = buffer_pool_manager_->FetchPageBasic(it.second);  // 获取该索引元信息所在的页
       IndexMetadata *index_meta = nullptr;
-      IndexMetadata::DeserializeFrom(index_meta_page->GetData(), index_meta);  // 将索引的元信息反序列化出来
+      IndexMetadata::DeserializeFrom(index_meta_guard.GetData(), index_meta);  // 将索引的元信息反序列化出来
       index_names_[tables_[index_meta->GetTableId()]->GetTableName()][index_meta->GetIndexName()] =
           index_meta->GetIndexId();                 // index_names_[表名][索引名] = index_id
       IndexInfo *index_info = IndexInfo::Create();  // 创建和初始化index_info，为后面赋值indexes_做准备
@@ -147,9 +148,6 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
     };
     // 定义一些临时变量
     page_id_t meta_page_id = 0;
-    Page *meta_page = nullptr;
-    page_id_t table_page_id = 0;
-    Page *table_page = nullptr;
     table_id_t table_id = 0;
     TableMetadata *table_meta_ = nullptr;
     TableHeap *table_heap_ = nullptr;
@@ -157,11 +155,11 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
 
     table_id = catalog_meta_->GetNextTableId();  // 获取一个table_id
     schema_ = Schema::DeepCopySchema(schema);  // 深拷贝，使得如果schema在函数执行期间被修改，不会影响到正在创建的表
-    meta_page = buffer_pool_manager_->NewPage(meta_page_id);                          // 获得一个新的meta_page
-    table_page = buffer_pool_manager_->NewPage(table_page_id);                        // 获得一个新的table_page
-    table_meta_ = TableMetadata::Create(table_id, table_name, table_page_id, schema_);  // 初始化table_meta
-    table_meta_->SerializeTo(meta_page->GetData());  // 将table_meta_序列化到meta_page中
-    table_heap_ = TableHeap::Create(buffer_pool_manager_, schema_, txn, log_manager_, lock_manager_);  // 初始化table_heap
+    auto meta_guard = buffer_pool_manager_->NewPageGuarded(meta_page_id);  // 获得一个新的meta_page
+    // 初始化table_heap，堆表自己申请首页，元信息中记录的首页必须是这一页
+    table_heap_ = TableHeap::Create(buffer_pool_manager_, schema_, txn, log_manager_, lock_manager_);
+    table_meta_ = TableMetadata::Create(table_id, table_name, table_heap_->GetFirstPageId(), schema_);  // 初始化table_meta
+    table_meta_->SerializeTo(meta_guard.GetDataMut());  // 将table_meta_序列化到meta_page中
     table_info = TableInfo::Create();                                                         // 初始化table_info
     table_info->Init(table_meta_, table_heap_);
 
@@ -171,10 +169,8 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
 
     // 赋值table_meta_pages_
     catalog_meta_->table_meta_pages_[table_id] = meta_page_id;
-    Page *page_ = buffer_pool_manager_->FetchPage(CATALOG_META_PAGE_ID);
-    char *buf = page_->GetData();
-    catalog_meta_->SerializeTo(buf);                              // 将catalog序列化到CATALOG_META_PAGE_ID
-    buffer_pool_manager_->UnpinPage(CATALOG_META_PAGE_ID, true);  // 脏页为true
+    auto catalog_guard = buffer_pool_manager_->FetchPageBasic(CATALOG_META_PAGE_ID);
+    catalog_meta_->SerializeTo(catalog_guard.GetDataMut());  // 将catalog序列化到CATALOG_META_PAGE_ID，脏页为true
     return DB_SUCCESS;
 }
 
@@ -237,7 +233,6 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     TableInfo *table_info_ = nullptr;
     // index
     page_id_t meta_page_id = 0;
-    Page *meta_page = nullptr;
     index_id_t index_id = 0;
     IndexMetadata *index_meta_ = nullptr;
     // index key map
@@ -259,13 +254,14 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
       key_map.push_back(column_index);
     }
     // 获取一个新页用来存储索引元信息
-    meta_page = buffer_pool_manager_->NewPage(meta_page_id);
+    auto meta_guard = buffer_pool_manager_->NewPageGuarded(meta_page_id);
     // 获取index id
     index_id = catalog_meta_->GetNextIndexId();
     // 利用四个元素创建索引元信息
     index_meta_ = IndexMetadata::Create(index_id, index_name, table_id, key_map);
     // 将索引元信息序列化到meta_page中
-    index_meta_->SerializeTo(meta_page->GetData());
+    index_meta_->SerializeTo(meta_guard.GetDataMut());
+    meta_guard.Drop();
     // 创建index_info
     index_info->Init(index_meta_, table_info_, buffer_pool_manager_);
     // 存储tablename+indexname -> indexid -> indexinfo
@@ -273,7 +269,7 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     indexes_[index_id] = index_info;
     auto table_heap = table_info_->GetTableHeap();
     vector<Field> f;
-    for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); it++) {
+    for (auto it = table_heap->Begin(nullptr, true); it != table_heap->End(); it++) {
       f.clear();
       for (auto pos : key_map) {
         f.push_back(*(it->GetField(pos)));
@@ -284,11 +280,9 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
 
     // 存储meta_page的id
     catalog_meta_->index_meta_pages_[index_id] = meta_page_id;
-    Page *page_ = buffer_pool_manager_->FetchPage(CATALOG_META_PAGE_ID);
-    char *buf = page_->GetData();
+    auto catalog_guard = buffer_pool_manager_->FetchPageBasic(CATALOG_META_PAGE_ID);
     // 将其序列化到page中
-    catalog_meta_->SerializeTo(buf);
-    buffer_pool_manager_->UnpinPage(CATALOG_META_PAGE_ID, true);
+    catalog_meta_->SerializeTo(catalog_guard.GetDataMut());
     return DB_SUCCESS;
 }
 
@@ -389,7 +383,6 @@ dberr_t CatalogManager::FlushCatalogMetaPage() const {
  */
 dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t page_id) {
     // init
-    Page *meta_page = nullptr;
     page_id_t table_page_id = 0;
     string table_name_;
     TableMetadata *table_meta_ = nullptr;
@@ -399,9 +392,9 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
     // 先初始化一下table_info
     table_info = TableInfo::Create();
     // 获取table_meta_page
-    meta_page = buffer_pool_manager_->FetchPage(page_id);
+    auto meta_guard = buffer_pool_manager_->FetchPageBasic(page_id);
     // 将该页中的data反序列化到table_meta中
-    TableMetadata::DeserializeFrom(meta_page->GetData(), table_meta_);
+    TableMetadata::DeserializeFrom(meta_guard.GetData(), table_meta_);
     // 要确保传进来的table_id和传进来的meta_page中记录的id是一样的
     ASSERT(table_id == table_meta_->GetTableId(), "Load wrong table");
     // 获取table_name, first_page, schema创建table_heap
@@ -422,15 +415,15 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
  * LoadIndex
  */
 dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t page_id) {
-    Page *meta_page = buffer_pool_manager_->FetchPage(page_id);  // 先获取存储索引元信息的页
+    auto meta_guard = buffer_pool_manager_->FetchPageBasic(page_id);  // 先获取存储索引元信息的页
     IndexMetadata *index_meta = nullptr;
-    IndexMetadata::DeserializeFrom(meta_page->GetData(), index_meta);  // 然后将该元信息反序列化到index_meta中
+    IndexMetadata::DeserializeFrom(meta_guard.GetData(), index_meta);  // 然后将该元信息反序列化到index_meta中
 
     table_id_t table_id = 0;
     table_id = index_meta->GetTableId();  // 获取表id
     TableInfo *table_info = nullptr;
     table_info = tables_[table_id];  // 利用表id获取table_info
-    IndexInfo *index_info = nullptr;
+    IndexInfo *index_info = IndexInfo::Create();
     index_info->Init(index_meta, table_info, buffer_pool_manager_);  // 利用index_meta和table_info创建index_info
     string table_name;
     table_name = table_info->GetTableName();  // 获取表名
@@ -12,7 +12,7 @@ IndexMetadata *IndexMetadata::Create(const index_id_t index_id, const string &in
 uint32_t IndexMetadata::SerializeTo(char *buf) const {
   char *p = buf;
   uint32_t ofs = GetSerializedSize();
-  ASSERT(ofs <= PAGE_SIZE, "Failed to serialize index info.");
+  ASSERT(ofs <= PAGE_USABLE_SIZE, "Failed to serialize index info.");
   // magic num
   MACH_WRITE_UINT32(buf, INDEX_METADATA_MAGIC_NUM);
   buf += 4;
@@ -47,11 +47,11 @@ uint32_t IndexMetadata::GetSerializedSize() const {
   return 4 + 4 + MACH_STR_SERIALIZED_SIZE(index_name_) + 4 + 4 + key_map_.size() * 4;
 }
 
-uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
+uint32_t IndexMetadata::DeserializeFrom(const char *buf, IndexMetadata *&index_meta) {
   if (index_meta != nullptr) {
     LOG(WARNING) << "Pointer object index info is not null in table info deserialize." << std::endl;
   }
-  char *p = buf;
+  const char *p = buf;
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
@@ -3,7 +3,7 @@
 uint32_t TableMetadata::SerializeTo(char *buf) const {
   char *p = buf;
   uint32_t ofs = GetSerializedSize();
-  ASSERT(ofs <= PAGE_SIZE, "Failed to serialize table info.");
+  ASSERT(ofs <= PAGE_USABLE_SIZE, "Failed to serialize table info.");
   // magic num
   MACH_WRITE_UINT32(buf, TABLE_METADATA_MAGIC_NUM);
   buf += 4;
@@ -35,11 +35,11 @@ uint32_t TableMetadata::GetSerializedSize() const {
  *
  * @param heap Memory heap passed by TableInfo
  */
-uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
+uint32_t TableMetadata::DeserializeFrom(const char *buf, TableMetadata *&table_meta) {
   if (table_meta != nullptr) {
     LOG(WARNING) << "Pointer object table info is not null in table info deserialize." << std::endl;
   }
-  char *p = buf;
+  const char *p = buf;
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
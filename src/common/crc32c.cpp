@@ -0,0 +1,162 @@
+#include "common/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace {
+constexpr uint32_t POLY = 0x82f63b78;  // the Castagnoli polynomial, bit reflected
+
+struct Tables {
+  uint32_t slice[8][256];
+  uint32_t x2n[32];  // x^(2^n) mod POLY
+};
+
+/**
+ * Multiply a and b modulo POLY, in the bit reflected representation where bit 31 is the coefficient of x^0.
+ */
+uint32_t MultModP(uint32_t a, uint32_t b) {
+  uint32_t m = 1u << 31;
+  uint32_t p = 0;
+  for (;;) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0) {
+        break;
+      }
+    }
+    m >>= 1;
+    b = b & 1 ? (b >> 1) ^ POLY : b >> 1;
+  }
+  return p;
+}
+
+const Tables &GetTables() {
+  static const Tables tables = []() {
+    Tables t{};
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t crc = n;
+      for (int k = 0; k < 8; k++) {
+        crc = crc & 1 ? (crc >> 1) ^ POLY : crc >> 1;
+      }
+      t.slice[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      for (int k = 1; k < 8; k++) {
+        t.slice[k][n] = (t.slice[k - 1][n] >> 8) ^ t.slice[0][t.slice[k - 1][n] & 0xff];
+      }
+    }
+    t.x2n[0] = 1u << 30;  // x^1
+    for (int k = 1; k < 32; k++) {
+      t.x2n[k] = MultModP(t.x2n[k - 1], t.x2n[k - 1]);
+    }
+    return t;
+  }();
+  return tables;
+}
+
+/** @return x^(8 * len) mod POLY, which appends len zero bytes to a CRC when multiplied with it */
+uint32_t ZerosOperator(size_t len) {
+  const Tables &tables = GetTables();
+  uint32_t p = 1u << 31;  // x^0
+  for (unsigned k = 3; len != 0; len >>= 1, k++) {
+    if (len & 1) {
+      p = MultModP(tables.x2n[k & 31], p);
+    }
+  }
+  return p;
+}
+
+/** Slicing-by-8 over the raw CRC register, i.e. without the initial and final inversion. */
+uint32_t PortableUpdate(uint32_t crc, const unsigned char *p, size_t len) {
+  const Tables &tables = GetTables();
+  while (len > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    crc = (crc >> 8) ^ tables.slice[0][(crc ^ *p++) & 0xff];
+    len--;
+  }
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    word ^= crc;
+    crc = tables.slice[7][word & 0xff] ^ tables.slice[6][(word >> 8) & 0xff] ^ tables.slice[5][(word >> 16) & 0xff] ^
+          tables.slice[4][(word >> 24) & 0xff] ^ tables.slice[3][(word >> 32) & 0xff] ^
+          tables.slice[2][(word >> 40) & 0xff] ^ tables.slice[1][(word >> 48) & 0xff] ^ tables.slice[0][word >> 56];
+    p += 8;
+    len -= 8;
+  }
+  while (len > 0) {
+    crc = (crc >> 8) ^ tables.slice[0][(crc ^ *p++) & 0xff];
+    len--;
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+/** Length of each of the three streams, a 4 KiB page is one round of them. */
+constexpr size_t STREAM_LEN = 1360;
+
+__attribute__((target("sse4.2"))) uint32_t HardwareUpdate(uint32_t crc, const unsigned char *p, size_t len) {
+  // 1. 三路交织计算，隐藏 crc32 指令 3 个周期的延迟，再通过乘以 x^(8 * STREAM_LEN) 把三段的结果合并
+  // 2. 剩余的字节逐字计算
+  static const uint32_t shift = ZerosOperator(STREAM_LEN);
+  uint64_t crc0 = crc;
+  while (len >= 3 * STREAM_LEN) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (size_t i = 0; i < STREAM_LEN; i += 8) {
+      uint64_t w0;
+      uint64_t w1;
+      uint64_t w2;
+      memcpy(&w0, p + i, 8);
+      memcpy(&w1, p + STREAM_LEN + i, 8);
+      memcpy(&w2, p + 2 * STREAM_LEN + i, 8);
+      crc0 = _mm_crc32_u64(crc0, w0);
+      crc1 = _mm_crc32_u64(crc1, w1);
+      crc2 = _mm_crc32_u64(crc2, w2);
+    }
+    crc0 = MultModP(shift, static_cast<uint32_t>(crc0)) ^ crc1;
+    crc0 = MultModP(shift, static_cast<uint32_t>(crc0)) ^ crc2;
+    p += 3 * STREAM_LEN;
+    len -= 3 * STREAM_LEN;
+  }
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    crc0 = _mm_crc32_u64(crc0, word);
+    p += 8;
+    len -= 8;
+  }
+  auto crc32 = static_cast<uint32_t>(crc0);
+  while (len > 0) {
+    crc32 = _mm_crc32_u8(crc32, *p++);
+    len--;
+  }
+  return crc32;
+}
+
+bool HasHardwareCrc() {
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+}
+#else
+uint32_t HardwareUpdate(uint32_t crc, const unsigned char *p, size_t len) { return PortableUpdate(crc, p, len); }
+
+bool HasHardwareCrc() { return false; }
+#endif
+}  // namespace
+
+uint32_t Crc32c(const void *data, size_t len, uint32_t crc) {
+  auto *p = static_cast<const unsigned char *>(data);
+  if (HasHardwareCrc()) {
+    return ~HardwareUpdate(~crc, p, len);
+  }
+  return ~PortableUpdate(~crc, p, len);
+}
+
+uint32_t Crc32cPortable(const void *data, size_t len, uint32_t crc) {
+  return ~PortableUpdate(~crc, static_cast<const unsigned char *>(data), len);
+}
+
+bool Crc32cIsHardwareAccelerated() { return HasHardwareCrc(); }
@@ -3,16 +3,22 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size, ReplacerType replacer_type,
+                                 DurabilityMode durability_mode, bool direct_io)
     : db_file_name_(std::move(db_name)), init_(init) {
   // Init database file if needed
+  // The dump file is hidden, so that ExecuteEngine does not take it for a database
+  dump_file_name_ = "./databases/." + db_file_name_ + ".bpdump";
   db_file_name_ = "./databases/" + db_file_name_;
   if (init_) {
     remove(db_file_name_.c_str());
+    remove(dump_file_name_.c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, durability_mode, direct_io);
+  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, DEFAULT_BUFFER_POOL_INSTANCES, replacer_type);
+  bpm_->EnableResidentPageDump(dump_file_name_);
+  bpm_->StartBackgroundWriter();
 
   // Allocate static page for db storage engine
   if (init) {
@@ -39,14 +45,135 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
   }
   catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+  if (!init) {
+    bpm_->LoadResidentPages(dump_file_name_);
+  }
 }
 
 DBStorageEngine::~DBStorageEngine() {
+  StopAutoVacuum();
   delete catalog_mgr_;
+  bpm_->StopWarmup();
+  // The background writer dumps the same file, stop it before the final dump
+  bpm_->StopBackgroundWriter();
+  bpm_->DumpResidentPages(dump_file_name_);
   delete bpm_;
   delete disk_mgr_;
 }
 
+void DBStorageEngine::Checkpoint() {
+  bpm_->FlushAllPages();
+  disk_mgr_->Sync();
+}
+
+void DBStorageEngine::Commit() {
+  if (disk_mgr_->GetDurabilityMode() == DurabilityMode::kPerCommit) {
+    Checkpoint();
+  }
+}
+
 std::unique_ptr<ExecuteContext> DBStorageEngine::MakeExecuteContext(Txn *txn) {
   return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_);
 }
+
+dberr_t DBStorageEngine::VacuumTable(const std::string &table_name, VacuumStats *stats, page_id_t *resume,
+                                     uint32_t max_pages) {
+  TableInfo *table_info = nullptr;
+  if (catalog_mgr_->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  std::vector<IndexInfo *> indexes;
+  catalog_mgr_->GetTableIndexes(table_name, indexes);
+  auto on_move = [&](Row &row, const RowId &old_rid) {
+    Row key_row;
+    for (auto info : indexes) {
+      row.GetKeyFromRow(table_info->GetSchema(), info->GetIndexKeySchema(), key_row);
+      info->GetIndex()->RemoveEntry(key_row, old_rid, nullptr);
+      info->GetIndex()->InsertEntry(key_row, row.GetRowId(), nullptr);
+    }
+  };
+  page_id_t start = resume == nullptr ? INVALID_PAGE_ID : *resume;
+  page_id_t next_page_id = table_info->GetTableHeap()->Vacuum(start, max_pages, on_move, stats, nullptr);
+  if (resume != nullptr) {
+    *resume = next_page_id;
+  }
+  return DB_SUCCESS;
+}
+
+void DBStorageEngine::StartAutoVacuum(uint32_t interval_ms, uint64_t dead_tuples, uint32_t chunk_pages) {
+  if (vacuum_thread_.joinable()) {
+    return;
+  }
+  vacuum_stop_ = false;
+  vacuum_thread_ = std::thread([this, interval_ms, dead_tuples, chunk_pages]() {
+    std::unique_lock<std::mutex> lock(vacuum_latch_);
+    while (!vacuum_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this]() { return vacuum_stop_; })) {
+      lock.unlock();
+      AutoVacuumRound(dead_tuples, chunk_pages);
+      lock.lock();
+    }
+  });
+}
+
+void DBStorageEngine::StopAutoVacuum() {
+  if (!vacuum_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(vacuum_latch_);
+    vacuum_stop_ = true;
+  }
+  vacuum_cv_.notify_all();
+  vacuum_thread_.join();
+}
+
+/**
+ * 每张表按 chunk_pages 页一段进行 vacuum，段与段之间释放 latch_ 让语句执行
+ * 表可能在两段之间被删除，因此每段都按表名重新查找，表不存在时跳过
+ * 两段之间用户的 VACUUM 可能已把续做的页并入前一页并释放，表也可能被删除后重建，续做的页可能已不在
+ * 这张表中：表号或页链的版本变了就从第一页重新开始
+ */
+void DBStorageEngine::AutoVacuumRound(uint64_t dead_tuples, uint32_t chunk_pages) {
+  std::vector<std::string> table_names;
+  {
+    std::lock_guard<std::recursive_mutex> lock(latch_);
+    std::vector<TableInfo *> tables;
+    catalog_mgr_->GetTables(tables);
+    for (auto table_info : tables) {
+      if (table_info->GetTableHeap()->GetNumDeadTuples() >= dead_tuples) {
+        table_names.push_back(table_info->GetTableName());
+      }
+    }
+  }
+  for (const auto &table_name : table_names) {
+    page_id_t page_id = INVALID_PAGE_ID;
+    table_id_t table_id = 0;
+    uint64_t chain_version = 0;
+    do {
+      {
+        std::lock_guard<std::mutex> lock(vacuum_latch_);
+        if (vacuum_stop_) {
+          return;
+        }
+      }
+      std::lock_guard<std::recursive_mutex> lock(latch_);
+      TableInfo *table_info = nullptr;
+      if (catalog_mgr_->GetTable(table_name, table_info) != DB_SUCCESS) {
+        break;
+      }
+      if (page_id != INVALID_PAGE_ID && (table_info->GetTableId() != table_id ||
+                                         table_info->GetTableHeap()->GetChainVersion() != chain_version)) {
+        page_id = INVALID_PAGE_ID;
+      }
+      VacuumStats stats;
+      if (VacuumTable(table_name, &stats, &page_id, chunk_pages) != DB_SUCCESS) {
+        break;
+      }
+      table_id = table_info->GetTableId();
+      chain_version = table_info->GetTableHeap()->GetChainVersion();
+      if (stats.tuples_removed > 0 || stats.pages_freed > 0) {
+        Commit();
+      }
+    } while (page_id != INVALID_PAGE_ID);
+  }
+}
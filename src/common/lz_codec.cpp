@@ -0,0 +1,164 @@
+#include "common/lz_codec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+constexpr int HASH_BITS = 12;
+constexpr size_t MAX_OFFSET = 65535;
+// no match starts in the last bytes of the input, so that finding one never reads beyond it
+constexpr size_t END_LITERALS = 5;
+
+inline uint32_t Load32(const char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t Hash(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_BITS); }
+
+/** Write the extra bytes of a length which did not fit in its nibble. */
+inline bool PutLength(size_t length, char *&op, const char *oend) {
+  for (; length >= 255; length -= 255) {
+    if (op == oend) {
+      return false;
+    }
+    *op++ = static_cast<char>(255);
+  }
+  if (op == oend) {
+    return false;
+  }
+  *op++ = static_cast<char>(length);
+  return true;
+}
+
+inline bool GetLength(size_t &length, const unsigned char *&ip, const unsigned char *iend) {
+  unsigned char b;
+  do {
+    if (ip == iend) {
+      return false;
+    }
+    b = *ip++;
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+/** Emit a sequence of the literals [anchor, literal_end) followed by a match, or by nothing if match_length is 0. */
+bool PutSequence(const char *anchor, const char *literal_end, size_t offset, size_t match_length, char *&op,
+                 const char *oend) {
+  size_t literals = literal_end - anchor;
+  if (op == oend) {
+    return false;
+  }
+  char *token = op++;
+  size_t match_code = match_length == 0 ? 0 : match_length - LZ_MIN_MATCH;
+  *token = static_cast<char>(((literals < 15 ? literals : 15) << 4) | (match_code < 15 ? match_code : 15));
+  if (literals >= 15 && !PutLength(literals - 15, op, oend)) {
+    return false;
+  }
+  if (static_cast<size_t>(oend - op) < literals) {
+    return false;
+  }
+  memcpy(op, anchor, literals);
+  op += literals;
+  if (match_length == 0) {
+    return true;
+  }
+  if (oend - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<char>(offset & 0xff);
+  *op++ = static_cast<char>(offset >> 8);
+  return match_code < 15 || PutLength(match_code - 15, op, oend);
+}
+}  // namespace
+
+/**
+ * 贪心匹配：用前 4 个字节的哈希找最近一次出现的位置，连续未匹配时加大步长，以便快速跳过不可压缩的数据
+ */
+size_t LzCompress(const char *src, size_t len, char *dst, size_t capacity) {
+  uint32_t table[1 << HASH_BITS];
+  memset(table, 0xff, sizeof(table));
+  const char *ip = src;
+  const char *anchor = src;
+  const char *iend = src + len;
+  char *op = dst;
+  const char *oend = dst + capacity;
+  if (len > END_LITERALS + LZ_MIN_MATCH) {
+    const char *match_limit = iend - END_LITERALS;
+    size_t misses = 0;
+    while (ip + LZ_MIN_MATCH <= match_limit) {
+      uint32_t h = Hash(Load32(ip));
+      uint32_t candidate = table[h];
+      table[h] = static_cast<uint32_t>(ip - src);
+      if (candidate == UINT32_MAX || static_cast<size_t>(ip - src) - candidate > MAX_OFFSET ||
+          Load32(src + candidate) != Load32(ip)) {
+        ip += 1 + (misses++ >> 5);
+        continue;
+      }
+      misses = 0;
+      const char *match = src + candidate;
+      size_t match_length = LZ_MIN_MATCH;
+      while (ip + match_length < match_limit && ip[match_length] == match[match_length]) {
+        match_length++;
+      }
+      if (!PutSequence(anchor, ip, ip - match, match_length, op, oend)) {
+        return 0;
+      }
+      ip += match_length;
+      anchor = ip;
+    }
+  }
+  if (!PutSequence(anchor, iend, 0, 0, op, oend)) {
+    return 0;
+  }
+  return op - dst;
+}
+
+bool LzDecompress(const char *src, size_t len, char *dst, size_t out_len) {
+  auto *ip = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *iend = ip + len;
+  char *op = dst;
+  char *oend = dst + out_len;
+  while (ip < iend) {
+    unsigned char token = *ip++;
+    size_t literals = token >> 4;
+    if (literals == 15 && !GetLength(literals, ip, iend)) {
+      return false;
+    }
+    if (static_cast<size_t>(iend - ip) < literals || static_cast<size_t>(oend - op) < literals) {
+      return false;
+    }
+    memcpy(op, ip, literals);
+    ip += literals;
+    op += literals;
+    if (ip == iend) {
+      break;
+    }
+    if (iend - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !GetLength(match_length, ip, iend)) {
+      return false;
+    }
+    match_length += LZ_MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(op - dst) || static_cast<size_t>(oend - op) < match_length) {
+      return false;
+    }
+    const char *match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      // 匹配与输出重叠，表示重复的模式，只能逐字节复制
+      for (size_t i = 0; i < match_length; i++) {
+        *op++ = *match++;
+      }
+    }
+  }
+  return op == oend;
+}
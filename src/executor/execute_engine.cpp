@@ -36,6 +36,7 @@ ExecuteEngine::ExecuteEngine() {
       continue;
     LOG(WARNING)<<stdir->d_name;
     dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false);
+    dbs_[stdir->d_name]->StartAutoVacuum();
   }
   closedir(dir);
 }
@@ -106,7 +107,14 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   }
   auto start_time = std::chrono::system_clock::now();
   unique_ptr<ExecuteContext> context(nullptr);
-  if (!current_db_.empty()) context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+  // 语句执行期间持有当前数据库的 latch_，与后台 vacuum 互斥；drop database 会停止后台 vacuum，不能持有
+  std::unique_lock<std::recursive_mutex> db_lock;
+  if (!current_db_.empty()) {
+    context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+    if (ast->type_ != kNodeDropDB) {
+      db_lock = std::unique_lock<std::recursive_mutex>(dbs_[current_db_]->latch_);
+    }
+  }
   switch (ast->type_) {
     case kNodeCreateDB:
       return ExecuteCreateDatabase(ast, context.get());
@@ -119,15 +127,19 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
     case kNodeShowTables:
       return ExecuteShowTables(ast, context.get());
     case kNodeCreateTable:
-      return ExecuteCreateTable(ast, context.get());
+      return CommitStatement(ExecuteCreateTable(ast, context.get()));
     case kNodeDropTable:
-      return ExecuteDropTable(ast, context.get());
+      return CommitStatement(ExecuteDropTable(ast, context.get()));
     case kNodeShowIndexes:
       return ExecuteShowIndexes(ast, context.get());
+    case kNodeShowStatus:
+      return ExecuteShowStatus(ast, context.get());
+    case kNodeVacuum:
+      return CommitStatement(ExecuteVacuum(ast, context.get()));
     case kNodeCreateIndex:
-      return ExecuteCreateIndex(ast, context.get());
+      return CommitStatement(ExecuteCreateIndex(ast, context.get()));
     case kNodeDropIndex:
-      return ExecuteDropIndex(ast, context.get());
+      return CommitStatement(ExecuteDropIndex(ast, context.get()));
     case kNodeTrxBegin:
       return ExecuteTrxBegin(ast, context.get());
     case kNodeTrxCommit:
@@ -148,6 +160,9 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
     planner.PlanQuery(ast);
     // Execute the query.
     ExecutePlan(planner.plan_, &result_set, nullptr, context.get());
+    if (planner.plan_->GetType() != PlanType::SeqScan && planner.plan_->GetType() != PlanType::IndexScan) {
+      CommitStatement(DB_SUCCESS);
+    }
   } catch (const exception &ex) {
     std::cout << "Error Encountered in Planner: " << ex.what() << std::endl;
     return DB_FAILED;
@@ -245,7 +260,9 @@ dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *co
   if (dbs_.find(db_name) != dbs_.end()) {
     return DB_ALREADY_EXIST;
   }
-  dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true)));
+  auto db = new DBStorageEngine(db_name, true);
+  db->StartAutoVacuum();
+  dbs_.insert(make_pair(db_name, db));
   return DB_SUCCESS;
 }
 
@@ -257,9 +274,16 @@ dberr_t ExecuteEngine::ExecuteDropDatabase(pSyntaxNode ast, ExecuteContext *cont
   if (dbs_.find(db_name) == dbs_.end()) {
     return DB_NOT_EXIST;
   }
-  remove(db_name.c_str());
+  // The engine dumps its buffer pool when deleted, remove its files afterwards
+  string db_file_name = dbs_[db_name]->db_file_name_;
+  string dump_file_name = dbs_[db_name]->dump_file_name_;
   delete dbs_[db_name];
   dbs_.erase(db_name);
+  remove(db_file_name.c_str());
+  remove(dump_file_name.c_str());
+  if (current_db_ == db_name) {
+    current_db_.clear();
+  }
   return DB_SUCCESS;
 }
 
@@ -515,6 +539,79 @@ dberr_t ExecuteEngine::ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *conte
   return DB_SUCCESS;
 }
 
+/**
+ * 输出当前数据库 buffer pool 的统计信息，用于根据实际命中率调整 DEFAULT_BUFFER_POOL_SIZE
+ */
+dberr_t ExecuteEngine::ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowStatus" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  BufferPoolManager *bpm = dbs_[current_db_]->bpm_;
+  BufferPoolStats stats = bpm->GetStats();
+  vector<pair<string, string>> rows;
+  rows.emplace_back("Buffer_pool_size", to_string(bpm->GetPoolSize()));
+  rows.emplace_back("Buffer_pool_instances", to_string(bpm->GetNumInstances()));
+  for (size_t i = 0; i < BufferPoolStats::kNumCounters; i++) {
+    auto counter = static_cast<BufferPoolStats::Counter>(i);
+    rows.emplace_back(BufferPoolStats::GetName(counter), to_string(stats.Get(counter)));
+  }
+  stringstream hit_ratio;
+  hit_ratio << fixed << setprecision(4) << stats.HitRatio();
+  rows.emplace_back("Buffer_pool_hit_ratio", hit_ratio.str());
+
+  string name_title("Variable_name");
+  string value_title("Value");
+  uint max_width_name = name_title.length();
+  uint max_width_value = value_title.length();
+  for (const auto &row : rows) {
+    max_width_name = max(max_width_name, static_cast<uint>(row.first.length()));
+    max_width_value = max(max_width_value, static_cast<uint>(row.second.length()));
+  }
+  cout << "+" << setfill('-') << setw(max_width_name + 2) << "" << "+";
+  cout << setfill('-') << setw(max_width_value + 2) << "" << "+" << endl;
+  cout << "| " << std::left << setfill(' ') << setw(max_width_name) << name_title << " |";
+  cout << " " << std::left << setfill(' ') << setw(max_width_value) << value_title << " |" << endl;
+  cout << "+" << setfill('-') << setw(max_width_name + 2) << "" << "+";
+  cout << setfill('-') << setw(max_width_value + 2) << "" << "+" << endl;
+  for (const auto &row : rows) {
+    cout << "| " << std::left << setfill(' ') << setw(max_width_name) << row.first << " |";
+    cout << " " << std::left << setfill(' ') << setw(max_width_value) << row.second << " |" << endl;
+  }
+  cout << "+" << setfill('-') << setw(max_width_name + 2) << "" << "+";
+  cout << setfill('-') << setw(max_width_value + 2) << "" << "+" << endl;
+  return DB_SUCCESS;
+}
+
+/**
+ * 回收表中被删除元组的空间并合并稀疏的页，输出 vacuum 的统计信息
+ */
+dberr_t ExecuteEngine::ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteVacuum" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  auto start_time = std::chrono::system_clock::now();
+  VacuumStats stats;
+  dberr_t result = dbs_[current_db_]->VacuumTable(ast->child_->val_, &stats);
+  if (result != DB_SUCCESS) {
+    return result;
+  }
+  auto stop_time = std::chrono::system_clock::now();
+  double duration_time =
+      double((std::chrono::duration_cast<std::chrono::milliseconds>(stop_time - start_time)).count());
+  cout << "Vacuumed " << stats.pages_scanned << " pages: " << stats.tuples_removed << " dead tuples removed, "
+       << stats.tuples_moved << " tuples moved, " << stats.pages_freed << " pages freed (" << fixed
+       << setprecision(4) << duration_time / 1000 << " sec)." << endl;
+  return DB_SUCCESS;
+}
+
 /**
  * DONE: Student Implement
  */
@@ -605,6 +702,13 @@ dberr_t ExecuteEngine::ExecuteDropIndex(pSyntaxNode ast, ExecuteContext *context
   return DB_SUCCESS;
 }
 
+dberr_t ExecuteEngine::CommitStatement(dberr_t result) {
+  if (result == DB_SUCCESS && !current_db_.empty()) {
+    dbs_[current_db_]->Commit();
+  }
+  return result;
+}
+
 dberr_t ExecuteEngine::ExecuteTrxBegin(pSyntaxNode ast, ExecuteContext *context) {
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteTrxBegin" << std::endl;
@@ -1,60 +1,199 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
-#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/buffer_ring.h"
+#include "buffer/page_guard.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/**
+ * BufferPoolManager partitions the pool into several BufferPoolManagerInstance shards selected by page id, each with
+ * its own latch, so concurrent requests for different pages do not serialize on a single lock.
+ *
+ * An optional background writer thread keeps a share of every shard clean, so that foreground misses rarely have to
+ * write back a dirty victim themselves. Prefetch requests are served asynchronously by a small pool of I/O workers,
+ * each of which issues up to PREFETCH_BATCH_PAGES reads as one batch.
+ *
+ * The list of resident pages can be dumped to a file and read back after a restart, the pages are then reloaded in
+ * the background so that the pool comes back warm without waiting for the workload to fault everything in again.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                             size_t num_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                             ReplacerType replacer_type = ReplacerType::kLRU);
 
   ~BufferPoolManager();
 
   Page *FetchPage(page_id_t page_id);
 
+  /**
+   * Fetch a page on behalf of a bulk read, pages read from disk are recycled through the ring.
+   * @param ring the access strategy of the caller, nullptr for a normal fetch
+   */
+  Page *FetchPage(page_id_t page_id, BufferRing *ring);
+
+  /**
+   * Pin the page only if it is resident and already read, never block on I/O.
+   * @return nullptr if the page is not available right now
+   */
+  Page *TryFetchPage(page_id_t page_id);
+
+  /**
+   * Ask an I/O worker to read the page into the pool, the page is left unpinned. The request is dropped if too many
+   * prefetches are pending.
+   * @param ring the access strategy the page is read on behalf of, nullptr for a normal read
+   */
+  void PrefetchPage(page_id_t page_id, std::shared_ptr<BufferRing> ring = nullptr);
+
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  /**
+   * Allocate a page on disk and pin it in the pool, zeroed.
+   * @param segment the segment the page belongs to, see PageSegment, nullptr to take the first free page
+   */
+  Page *NewPage(page_id_t &page_id, PageSegment *segment = nullptr);
 
   bool DeletePage(page_id_t page_id);
 
+  /**
+   * Guarded variants of FetchPage and NewPage, the pin is released when the guard goes out of scope.
+   * The returned guard is invalid if the page could not be pinned.
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id);
+
+  /** Same as FetchPageBasic, and the read latch of the page is held by the guard. */
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+
+  /** Same as FetchPageBasic, and the write latch of the page is held by the guard. */
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  BasicPageGuard NewPageGuarded(page_id_t &page_id, PageSegment *segment = nullptr);
+
   bool IsPageFree(page_id_t page_id);
 
+  /** Write back all the dirty pages of the pool, the writes are not synced. */
+  void FlushAllPages();
+
   bool CheckAllUnpinned();
 
+  /**
+   * Start the background writer, which calls WriteBackDirtyPages every interval_ms milliseconds, and syncs the disk
+   * manager every SYNC_INTERVAL_MS in kPeriodic durability mode.
+   * @param clean_percent the share of frames to keep clean
+   * @param max_pages the I/O budget of one round, in pages
+   */
+  void StartBackgroundWriter(size_t clean_percent = BGWRITER_CLEAN_PERCENT, size_t max_pages = BGWRITER_MAX_PAGES,
+                             uint32_t interval_ms = BGWRITER_INTERVAL_MS);
+
+  /** Stop the background writer and wait for its current round to finish. */
+  void StopBackgroundWriter();
+
+  /**
+   * Run one round of the background writer, the budget is shared evenly by the shards.
+   * @return the number of pages written
+   */
+  size_t WriteBackDirtyPages(size_t max_pages, size_t clean_percent);
+
+  /**
+   * Write the ids of the resident pages to file_name, most recently accessed first. The list is written to a
+   * temporary file which is then renamed, so a crash never leaves a truncated dump behind.
+   * @return false if the file could not be written
+   */
+  bool DumpResidentPages(const string &file_name);
+
+  /**
+   * Read a list written by DumpResidentPages and reload its pages in the background, in page id order and in
+   * batches of WARMUP_BATCH_PAGES. The warm-up only fills free frames, it never evicts a page the workload already
+   * brought in, and pages freed since the dump are skipped.
+   * @return the number of pages scheduled for reloading, 0 if the file is missing or invalid
+   */
+  size_t LoadResidentPages(const string &file_name);
+
+  /** Stop the warm-up started by LoadResidentPages, if any, and wait for its current batch to finish. */
+  void StopWarmup();
+
+  /**
+   * Let the background writer also dump the resident pages to file_name every interval_ms milliseconds, so that a
+   * crash does not lose the list. Takes effect with the next StartBackgroundWriter.
+   */
+  void EnableResidentPageDump(const string &file_name, uint32_t interval_ms = BUFFER_POOL_DUMP_INTERVAL_MS);
+
+  /** @return the number of shards the pool is split into */
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  /** @return the activity counters summed over all the shards */
+  BufferPoolStats GetStats() const;
+
+  /** @return the activity counters of one shard, instance_index < GetNumInstances() */
+  BufferPoolStats GetInstanceStats(size_t instance_index) const;
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(PageSegment *segment);
 
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /** Register a page read from disk on behalf of a ring, and recycle the page falling out of the ring. */
+  void PushToRing(BufferRing *ring, page_id_t page_id);
+
+  /** Main loop of the I/O workers. */
+  void PrefetchWorker();
+
+  /**
+   * Read the pages which are not resident yet into the pool with one batch of I/Os, the pages are left unpinned.
+   * @param may_evict whether resident pages may be evicted for them, otherwise only free frames are used
+   * @return for each page, whether it was read from disk
+   */
+  vector<bool> PrefetchBatch(const vector<page_id_t> &page_ids, bool may_evict);
+
+  /** Body of the warm-up thread, page_ids are sorted. */
+  void WarmUp(vector<page_id_t> page_ids);
+
+  /** @return the shard responsible for the page */
+  inline BufferPoolManagerInstance *GetInstance(page_id_t page_id) {
+    return instances_[static_cast<size_t>(page_id) % instances_.size()];
+  }
 
  private:
   size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
   DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  vector<BufferPoolManagerInstance *> instances_;    // shards of the buffer pool
+  thread bg_writer_;                                 // background writer thread, if started
+  mutex bg_latch_;                                   // protects bg_stop_
+  condition_variable bg_cv_;                         // wakes up the background writer when it has to stop
+  bool bg_stop_{false};                              // whether the background writer has to stop
+  vector<thread> io_workers_;                        // I/O workers serving prefetch requests, started on demand
+  deque<pair<page_id_t, shared_ptr<BufferRing>>> prefetch_queue_;  // pending prefetch requests
+  mutex prefetch_latch_;                             // protects prefetch_queue_ and prefetch_stop_
+  condition_variable prefetch_cv_;                   // signaled when a request is queued or the workers have to stop
+  bool prefetch_stop_{false};                        // whether the I/O workers have to stop
+  thread warmup_;                                    // reloads the pages of a dump, if one was loaded
+  atomic<bool> warmup_stop_{false};                  // whether the warm-up has to stop
+  string dump_file_;                                 // where the background writer dumps the resident pages
+  uint32_t dump_interval_ms_{0};                     // delay between two dumps, 0 to disable them
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
-
-
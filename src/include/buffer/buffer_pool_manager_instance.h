@@ -0,0 +1,198 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/frame_table.h"
+#include "buffer/replacer.h"
+#include "page/page.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/**
+ * BufferPoolManagerInstance is one shard of the buffer pool. It owns its own frames, page table, free list,
+ * replacer and latch, so that requests for pages living in different shards never contend with each other.
+ *
+ * Page ids are allocated and de-allocated by BufferPoolManager, an instance only caches them.
+ *
+ * Disk I/O is never performed with latch_ held, flushes included. A frame being filled is reserved in the page table
+ * and marked io_in_progress_, threads requesting the same page pin it and wait on io_cv_ until the read completes,
+ * while hits on other pages proceed. A page being written back, as a dirty victim, by the background writer or by a
+ * flush, stays in writing_pages_ until the write completes, so nobody reads a stale copy of it from disk or writes it
+ * concurrently. Only victims are written from their frame, the other writers write a copy taken under latch_.
+ *
+ * Activity counters are kept in atomics outside latch_, see GetStats.
+ *
+ * A miss whose victim is dirty issues the write-back and the read as one linked batch, and the background writer
+ * submits all its writes as one batch, see DiskManager::SubmitBatch.
+ */
+class BufferPoolManagerInstance {
+ public:
+  /** A prefetch started by StartPrefetch, whose I/O is in flight. */
+  struct PendingPrefetch {
+    frame_id_t frame_id;
+    page_id_t dirty_page_id;
+  };
+
+  explicit BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = ReplacerType::kLRU);
+
+  ~BufferPoolManagerInstance();
+
+  /**
+   * @param[out] is_miss set to whether the page had to be read from disk
+   */
+  Page *FetchPage(page_id_t page_id, bool *is_miss = nullptr);
+
+  /**
+   * Pin the page only if it is resident and its content is in memory, never wait nor read from disk.
+   * @return nullptr if the page is not available right now
+   */
+  Page *TryFetchPage(page_id_t page_id);
+
+  /**
+   * Read the page into an unpinned frame if it is not resident yet.
+   * @param may_evict whether a resident page may be evicted for it, otherwise only a free frame is used
+   * @return true if the page was read from disk
+   */
+  bool PrefetchPage(page_id_t page_id, bool may_evict = true);
+
+  /**
+   * First half of PrefetchPage: reserve a frame for the page and queue its read into batch, after the write-back of
+   * the victim if it is dirty. The frame stays io_in_progress until FinishPrefetch, which must be called once the batch
+   * completed.
+   * @return false if the page is resident already or no frame is available, nothing was queued then
+   */
+  bool StartPrefetch(page_id_t page_id, bool may_evict, IoBatch &batch, PendingPrefetch *pending);
+
+  /**
+   * Publish the page read by a completed prefetch.
+   * @param io_time_ns the share of the batch duration accounted to this page
+   */
+  void FinishPrefetch(const PendingPrefetch &pending, uint64_t io_time_ns);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Write back the page if it is dirty, a copy of it is written without the latch.
+   * @return false if the page is not resident
+   */
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Install a zeroed, pinned frame for a page id which has already been allocated on disk.
+   * @return nullptr if all the frames of this instance are pinned
+   */
+  Page *NewPage(page_id_t page_id);
+
+  /**
+   * Drop the page from this instance.
+   * @return false if the page is resident and still pinned
+   */
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * Give the frame of an unpinned, clean page back to the free list, used by bulk reads to recycle their frames.
+   * @return false if the page is not resident, pinned or dirty
+   */
+  bool DiscardPage(page_id_t page_id);
+
+  /**
+   * Write back dirty unpinned pages in page id order until at most (100 - clean_percent)% of the frames are dirty,
+   * so that foreground misses find clean victims. Copies of the pages are written without the latch.
+   * @param max_pages the I/O budget of this call
+   * @return the number of pages written
+   */
+  size_t WriteBackDirtyPages(size_t max_pages, size_t clean_percent);
+
+  bool CheckAllUnpinned();
+
+  /** Write back all the dirty pages held by this instance as one batch, after the write-backs already in flight. */
+  void FlushAllPages();
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  /**
+   * @return the ids of the pages whose content is in memory, most recently accessed first. Pages read ahead but not
+   * accessed yet come last.
+   */
+  vector<page_id_t> GetResidentPages();
+
+  /** @return a snapshot of the activity counters of this instance */
+  BufferPoolStats GetStats() const;
+
+ private:
+  /**
+   * Pick a frame from the free list, or evict one chosen by the replacer. Must be called with latch_ held.
+   * @param[out] dirty_page_id the evicted page which must be written back by the caller, or INVALID_PAGE_ID
+   * @return false if all the frames are pinned
+   */
+  bool TryToFindFreeFrame(frame_id_t *frame_id, page_id_t *dirty_page_id);
+
+  /** Block until no write-back of the page is in flight. Must be called with latch_ held. */
+  void WaitForWriteBack(page_id_t page_id, unique_lock<mutex> &lock);
+
+  /** Publish the end of the I/O on a frame and wake up its waiters. Must be called with latch_ held. */
+  void FinishIo(Page &page, page_id_t dirty_page_id);
+
+  bool FlushPageImpl(page_id_t page_id, unique_lock<mutex> &lock);
+
+  /**
+   * Copy the pages, mark them clean and write the copies as one batch without the latch, the pages stay in
+   * writing_pages_ meanwhile. Must be called with latch_ held, none of the pages may be in writing_pages_.
+   */
+  void WriteCopies(const vector<pair<page_id_t, frame_id_t>> &pages, unique_lock<mutex> &lock);
+
+  /** Wait on io_cv_ until pred holds, the time blocked is accounted as I/O wait. Must be called with latch_ held. */
+  template <class Predicate>
+  void WaitForIo(unique_lock<mutex> &lock, Predicate pred) {
+    if (pred()) {
+      return;
+    }
+    auto start = chrono::steady_clock::now();
+    io_cv_.wait(lock, pred);
+    Count(BufferPoolStats::kIoWaitTimeNs, ElapsedNs(start));
+  }
+
+  /** Disk I/O of this instance goes through these two, which keep the I/O counters. */
+  void ReadFromDisk(page_id_t page_id, char *page_data);
+
+  void WriteToDisk(page_id_t page_id, const char *page_data);
+
+  /** Submit the batch and wait for it, the time is accounted to reads if it contains any, to writes otherwise. */
+  void RunBatch(IoBatch &batch);
+
+  inline void Count(BufferPoolStats::Counter counter, uint64_t n = 1) {
+    counters_[counter].fetch_add(n, memory_order_relaxed);
+  }
+
+  static inline uint64_t ElapsedNs(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+  }
+
+ private:
+  size_t pool_size_;                                 // number of pages in this instance
+  FrameTable frames_;                                // metadata and data of the frames
+  Page *pages_;                                      // array of pages, the metadata part of frames_
+  DiskManager *disk_manager_;                        // pointer to the disk manager.
+  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
+  Replacer *replacer_;                               // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                       // to find a free page for replacement
+  mutex latch_;                                      // to protect shared data structure
+  condition_variable io_cv_;                         // signaled when an I/O on a frame completes
+  unordered_set<page_id_t> writing_pages_;           // pages being written back without the latch
+  vector<uint64_t> last_access_;                     // logical time of the last access to each frame, 0 if none
+  uint64_t access_clock_{0};                         // ticks on every access, protected by latch_
+  atomic<uint64_t> counters_[BufferPoolStats::kNumCounters]{};  // activity counters, see BufferPoolStats
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
@@ -0,0 +1,49 @@
+#ifndef MINISQL_BUFFER_POOL_STATS_H
+#define MINISQL_BUFFER_POOL_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * BufferPoolStats is a snapshot of the activity counters of the buffer pool, either of one shard or summed over all
+ * of them. Shards update their counters with relaxed atomics, so a snapshot is not a consistent cut, only each
+ * counter is exact.
+ */
+class BufferPoolStats {
+ public:
+  enum Counter : size_t {
+    kFetches,         // FetchPage calls
+    kHits,            // fetches served from memory
+    kMisses,          // fetches which read the page from disk
+    kPrefetches,      // pages read ahead by the I/O workers
+    kEvictions,       // pages evicted by the replacer
+    kDirtyEvictions,  // evicted pages which had to be written back first
+    kFlushes,         // pages written by FlushPage
+    kBgWrites,        // pages written by the background writer
+    kNewPages,        // NewPage calls
+    kDeletedPages,    // DeletePage calls
+    kDiskReads,       // pages read from disk
+    kDiskWrites,      // pages written to disk
+    kReadTimeNs,      // time spent in disk reads
+    kWriteTimeNs,     // time spent in disk writes
+    kIoWaitTimeNs,    // time spent waiting for an I/O issued by another thread
+    kNumCounters
+  };
+
+  inline uint64_t Get(Counter counter) const { return values_[counter]; }
+
+  inline void Set(Counter counter, uint64_t value) { values_[counter] = value; }
+
+  /** @return the name of the counter as shown by SHOW STATUS */
+  static const char *GetName(Counter counter);
+
+  /** @return hits / fetches, 0 if there was no fetch yet */
+  double HitRatio() const;
+
+  BufferPoolStats &operator+=(const BufferPoolStats &that);
+
+ private:
+  uint64_t values_[kNumCounters]{};
+};
+
+#endif  // MINISQL_BUFFER_POOL_STATS_H
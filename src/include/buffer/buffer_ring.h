@@ -0,0 +1,36 @@
+#ifndef MINISQL_BUFFER_RING_H
+#define MINISQL_BUFFER_RING_H
+
+#include <deque>
+#include <mutex>
+
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * BufferRing is the buffer access strategy of bulk reads such as full table scans and index backfills.
+ *
+ * Pages read from disk on behalf of the ring owner are remembered here. Once more than the ring size of them have
+ * been loaded, the buffer pool gives the frame of the oldest one back to the free list, provided nobody pinned or
+ * dirtied it in the meantime, so a large scan recycles a few dozen frames instead of evicting the whole pool.
+ */
+class BufferRing {
+ public:
+  explicit BufferRing(size_t ring_size = DEFAULT_BUFFER_RING_SIZE);
+
+  /**
+   * Remember a page loaded through this ring.
+   * @return the page which falls out of the ring and should be discarded, or INVALID_PAGE_ID
+   */
+  page_id_t Push(page_id_t page_id);
+
+  inline size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  size_t ring_size_;
+  deque<page_id_t> pages_;  // pages loaded through this ring, the oldest first
+  mutex latch_;             // iterators sharing a ring may be used by different threads
+};
+
+#endif  // MINISQL_BUFFER_RING_H
@@ -1,12 +1,6 @@
 #ifndef MINISQL_CLOCK_REPLACER_H
 #define MINISQL_CLOCK_REPLACER_H
 
-#include <algorithm>
-#include <list>
-#include <map>
-#include <mutex>
-#include <queue>
-#include <unordered_set>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -15,7 +9,10 @@
 using namespace std;
 
 /**
- * CLOCKReplacer implements the clock replacement.
+ * CLOCKReplacer implements the clock (second-chance) replacement.
+ *
+ * Each frame owns a slot in two bit arrays: whether it can be victimized and its reference bit. Pin and Unpin only
+ * flip bits, Victim sweeps the clock hand clearing reference bits until it meets an unreferenced frame.
  */
 class CLOCKReplacer : public Replacer {
  public:
@@ -40,8 +37,10 @@ class CLOCKReplacer : public Replacer {
 
  private:
   size_t capacity;
-  list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
-  map<frame_id_t, frame_id_t> clock_status;  // 数据页的存储状态
+  size_t size_{0};            // replacer中可以被替换的数据页数
+  size_t hand_{0};            // 时钟指针
+  vector<bool> in_replacer_;  // 数据页是否可以被替换
+  vector<bool> ref_bits_;     // 数据页的访问位
 };
 
 #endif  // MINISQL_CLOCK_REPLACER_H
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef MINISQL_FRAME_TABLE_H
+#define MINISQL_FRAME_TABLE_H
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "page/page.h"
+
+/**
+ * FrameTable holds the frames of a buffer pool instance as a structure of arrays: the Page objects, i.e. the
+ * metadata of the frames (page id, pin count, dirty flag, latch), form a dense array, and the bytes of the pages live
+ * in a separate slab of memory. A sweep over the metadata, e.g. CheckAllUnpinned or the background writer, thus
+ * reads a few consecutive cache lines instead of one line every PAGE_SIZE bytes.
+ *
+ * The slab is mapped anonymously, PAGE_SIZE aligned for O_DIRECT. Slabs of at least HUGE_PAGE_SIZE are aligned to it
+ * and backed by transparent huge pages, or by reserved huge pages (hugetlbfs) with BUFFER_POOL_HUGETLB when the
+ * system has enough of them. The slab is zero-filled and faulted in on first use.
+ */
+class FrameTable {
+ public:
+  static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+  explicit FrameTable(size_t num_frames);
+
+  ~FrameTable();
+
+  DISALLOW_COPY_AND_MOVE(FrameTable);
+
+  inline Page *GetPages() const { return pages_; }
+
+  inline size_t GetNumFrames() const { return num_frames_; }
+
+  /** @return the start of the page data slab, the data of frame i is at i * PAGE_SIZE */
+  inline char *GetData() const { return data_; }
+
+  /** @return whether the slab is backed by reserved huge pages */
+  inline bool IsHugeTlb() const { return huge_tlb_; }
+
+ private:
+  size_t num_frames_;
+  Page *pages_;           // metadata of the frames, dense
+  char *data_;            // data of the frames, PAGE_SIZE aligned
+  void *mapping_;         // the mapping holding data_
+  size_t mapping_size_;   // length of the mapping
+  bool huge_tlb_{false};  // whether the mapping uses reserved huge pages
+};
+
+#endif  // MINISQL_FRAME_TABLE_H
@@ -0,0 +1,66 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * Every Pin is an access to the frame. The victim is the evictable frame whose K-th most recent access is the oldest;
+ * frames referenced fewer than K times have an infinite backward K-distance and are evicted first, in the order of
+ * their first access. One-shot pages, such as those read by a sequential scan, therefore age out before pages which
+ * are re-referenced, such as B+ tree internal pages and catalog pages.
+ *
+ * Accesses less than correlated_period ticks after the previous access to the same frame are correlated (e.g. the
+ * repeated fetches of a table page while iterating over its tuples) and count as a single reference.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of references tracked per frame
+   * @param correlated_period accesses closer than this many ticks to the previous one are not counted again
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        uint64_t correlated_period = LRUK_CORRELATED_PERIOD);
+
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  using Key = tuple<bool, uint64_t, frame_id_t>;  // (has K references, K-th most recent or first access, frame)
+
+  void RecordAccess(frame_id_t frame_id);
+
+  Key GetKey(frame_id_t frame_id) const;
+
+ private:
+  size_t max_pages_;
+  size_t k_;
+  uint64_t correlated_period_;
+  uint64_t current_tick_{0};
+  vector<uint64_t> history_;      // history_[i * k_, (i + 1) * k_): ring of the last k_ references of frame i
+  vector<size_t> access_count_;   // number of references of frame i since it was loaded
+  vector<uint64_t> last_access_;  // tick of the latest (possibly correlated) access of frame i
+  vector<bool> in_replacer_;      // whether frame i can be victimized
+  set<Key> evictable_;            // evictable frames, the victim first
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -1,9 +1,6 @@
 #ifndef MINISQL_LRU_REPLACER_H
 #define MINISQL_LRU_REPLACER_H
 
-#include <list>
-#include <mutex>
-#include <unordered_set>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -13,6 +10,10 @@ using namespace std;
 
 /**
  * LRUReplacer implements the Least Recently Used replacement policy.
+ *
+ * The LRU list is an intrusive doubly linked list over frame ids: prev_[i] / next_[i] are the neighbours of frame i,
+ * and slot max_pages_ is the sentinel whose next_ is the most recently unpinned frame and whose prev_ is the victim.
+ * Pin, Unpin and Victim are therefore O(1) and never allocate.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -33,14 +34,20 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Remove(frame_id_t frame_id) override;
+
   size_t Size() override;
 
-private:
-  mutex latch_;
+ private:
+  /** Unlink the frame from the LRU list, the frame must be in the list. */
+  void Unlink(frame_id_t frame_id);
+
+ private:
   size_t max_pages_;
-  list<frame_id_t> lru_list_;
-  unordered_set<frame_id_t> frame_set_; // Set to quickly check presence of a frame
-  // add your own private member variables here
+  size_t size_{0};           // number of frames in the LRU list
+  vector<frame_id_t> prev_;  // prev_[i]: the frame used more recently than frame i
+  vector<frame_id_t> next_;  // next_[i]: the frame used less recently than frame i
+  vector<bool> in_list_;     // whether frame i can be victimized
 };
 
 #endif  // MINISQL_LRU_REPLACER_H
@@ -0,0 +1,199 @@
+#ifndef MINISQL_PAGE_GUARD_H
+#define MINISQL_PAGE_GUARD_H
+
+#include <utility>
+
+#include "page/page.h"
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns one pin of a page and unpins it when it goes out of scope, so that an early return or an
+ * exception can not leak a pin. Guards are move-only, moving one transfers the pin and leaves the source empty.
+ *
+ * A page is unpinned dirty if it was accessed through GetPageMut()/GetDataMut()/AsMut() or marked with SetDirty().
+ * GetPage()/GetData()/As() only hand out const pointers and leave the dirty flag alone.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /** Adopt a pin already held on the page, page may be nullptr. */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Drop the page currently held, then take over the pin of that. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  ~BasicPageGuard();
+
+  /** Unpin the page now, the guard becomes empty. */
+  void Drop();
+
+  /**
+   * Take the read latch of the page, the pin is moved into the returned guard.
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Take the write latch of the page, the pin is moved into the returned guard.
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return false if the guard holds no page, e.g. the fetch failed */
+  inline bool IsValid() const { return page_ != nullptr; }
+
+  inline explicit operator bool() const { return IsValid(); }
+
+  inline page_id_t PageId() const { return page_->GetPageId(); }
+
+  inline const Page *GetPage() const { return page_; }
+
+  inline const char *GetData() const { return page_->GetData(); }
+
+  template <class T>
+  inline const T *As() const {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** For page types such as TablePage which are accessed through the Page object itself. */
+  inline Page *GetPageMut() {
+    is_dirty_ = true;
+    return page_;
+  }
+
+  inline char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  template <class T>
+  inline T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  /** Read the page without its latch, see Page::ReadOptimistic. */
+  template <class Fn>
+  inline bool ReadOptimistic(Fn &&read) {
+    return page_->ReadOptimistic(std::forward<Fn>(read));
+  }
+
+  /** Mark the page dirty, for callers modifying it through the Page object itself. */
+  inline void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch of a page, both are released when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** Adopt a pin and the read latch already held on the page. */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard();
+
+  /** Release the read latch and unpin the page now. */
+  void Drop();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+
+  inline explicit operator bool() const { return IsValid(); }
+
+  inline page_id_t PageId() const { return guard_.PageId(); }
+
+  inline const Page *GetPage() const { return guard_.GetPage(); }
+
+  inline const char *GetData() const { return guard_.GetData(); }
+
+  template <class T>
+  inline const T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch of a page, both are released when it goes out of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** Adopt a pin and the write latch already held on the page. */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard();
+
+  /** Release the write latch and unpin the page now. */
+  void Drop();
+
+  inline bool IsValid() const { return guard_.IsValid(); }
+
+  inline explicit operator bool() const { return IsValid(); }
+
+  inline page_id_t PageId() const { return guard_.PageId(); }
+
+  inline const Page *GetPage() const { return guard_.GetPage(); }
+
+  inline const char *GetData() const { return guard_.GetData(); }
+
+  template <class T>
+  inline const T *As() const {
+    return guard_.As<T>();
+  }
+
+  inline Page *GetPageMut() { return guard_.GetPageMut(); }
+
+  inline char *GetDataMut() { return guard_.GetDataMut(); }
+
+  template <class T>
+  inline T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+  inline void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+#endif  // MINISQL_PAGE_GUARD_H
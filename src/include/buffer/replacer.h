@@ -5,8 +5,16 @@
 
 #include "common/config.h"
 
+/**
+ * Replacement policies the buffer pool can be built with.
+ */
+enum class ReplacerType { kLRU, kClock, kLRUK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
+ *
+ * Replacers have no latch of their own and are not thread-safe: every call comes from the BufferPoolManagerInstance
+ * owning the replacer with the latch of that shard held, which already serializes them, so a hit pays for one lock.
  */
 class Replacer {
  public:
@@ -33,8 +41,21 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forget a frame whose page has left the buffer pool, it is not evictable until unpinned again.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Create a replacer implementing the given policy.
+   * @param type the replacement policy
+   * @param num_pages the maximum number of pages the replacer will be required to store
+   */
+  static Replacer *Create(ReplacerType type, size_t num_pages);
 };
 
 #endif  // MINISQL_REPLACER_H
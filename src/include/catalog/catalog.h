@@ -20,7 +20,7 @@ class CatalogMeta {
  public:
   void SerializeTo(char *buf) const;
 
-  static CatalogMeta *DeserializeFrom(char *buf);
+  static CatalogMeta *DeserializeFrom(const char *buf);
 
   uint32_t GetSerializedSize() const;
 
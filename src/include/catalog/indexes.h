@@ -21,7 +21,7 @@ class IndexMetadata {
 
   uint32_t GetSerializedSize() const;
 
-  static uint32_t DeserializeFrom(char *buf, IndexMetadata *&index_meta);
+  static uint32_t DeserializeFrom(const char *buf, IndexMetadata *&index_meta);
 
   inline std::string GetIndexName() const { return index_name_; }
 
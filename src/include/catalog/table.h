@@ -17,7 +17,7 @@ class TableMetadata {
 
   uint32_t GetSerializedSize() const;
 
-  static uint32_t DeserializeFrom(char *buf, TableMetadata *&table_meta);
+  static uint32_t DeserializeFrom(const char *buf, TableMetadata *&table_meta);
 
   /*
    * will create new table schema and owned by mem heap
@@ -14,7 +14,32 @@ static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalo
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
 static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
+static constexpr int PAGE_CHECKSUM_SIZE = 4;            // CRC32C stamped by the disk manager at the end of every page
+static constexpr int PAGE_USABLE_SIZE = PAGE_SIZE - PAGE_CHECKSUM_SIZE;  // bytes of a page its content may use
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 8; // default number of buffer pool shards
+static constexpr int MIN_FRAMES_PER_INSTANCE = 64;      // pools smaller than this per shard are not split further
+static constexpr int DEFAULT_BUFFER_RING_SIZE = 32;     // number of pages a bulk read keeps in the buffer pool
+static constexpr int PREFETCH_WORKERS = 2;             // number of I/O workers serving prefetch requests
+static constexpr int PREFETCH_QUEUE_SIZE = 256;        // prefetch requests beyond this many pending ones are dropped
+static constexpr int PREFETCH_BATCH_PAGES = 16;        // prefetch requests an I/O worker issues as one batch
+static constexpr int READAHEAD_PAGES = 8;              // number of pages a sequential scan keeps in flight
+static constexpr int BGWRITER_CLEAN_PERCENT = 25;      // share of frames the background writer keeps clean
+static constexpr int BGWRITER_MAX_PAGES = 128;         // I/O budget of the background writer per round, in pages
+static constexpr int BGWRITER_INTERVAL_MS = 20;        // delay between two rounds of the background writer
+static constexpr int BUFFER_POOL_DUMP_INTERVAL_MS = 60000;  // delay between two dumps of the resident page list
+static constexpr int WARMUP_BATCH_PAGES = 64;          // pages read per batch when warming up the pool after a restart
+static constexpr int ASYNC_IO_DEPTH = 128;             // I/Os kept in flight at most by the io_uring backend
+static constexpr int SYNC_INTERVAL_MS = 1000;          // delay between two syncs of the db file in periodic durability
+static constexpr bool BUFFER_POOL_HUGETLB = false;     // back the frames with reserved huge pages instead of THP
+static constexpr int SEGMENT_RUN_PAGES = 32;           // contiguous pages a table heap or an index reserves at a time
+static constexpr int COMPRESSED_SECTOR_SIZE = 512;     // unit of the slots holding compressed pages
+static constexpr int LRUK_REPLACER_K = 2;               // number of references tracked by the LRU-K replacer
+static constexpr int LRUK_CORRELATED_PERIOD = 16;       // LRU-K accesses closer than this many ticks count once
+static constexpr int OPTIMISTIC_READ_RETRIES = 4;       // optimistic read attempts before taking the read latch
+static constexpr int AUTO_VACUUM_INTERVAL_MS = 1000;    // delay between two rounds of the background vacuum
+static constexpr int AUTO_VACUUM_DEAD_TUPLES = 1000;    // deleted tuples of a table which trigger a background vacuum
+static constexpr int AUTO_VACUUM_CHUNK_PAGES = 64;      // pages the background vacuum handles per hold of the latch
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
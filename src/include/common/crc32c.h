@@ -0,0 +1,22 @@
+#ifndef MINISQL_CRC32C_H
+#define MINISQL_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CRC32C (Castagnoli) of len bytes, as used by iSCSI and ext4.
+ *
+ * Computed with the SSE4.2 crc32 instruction when the CPU has it, over three interleaved streams so that the latency
+ * of the instruction is hidden, and with a slicing-by-8 table otherwise.
+ * @param crc the CRC32C of the preceding bytes, to checksum a buffer in several pieces
+ */
+uint32_t Crc32c(const void *data, size_t len, uint32_t crc = 0);
+
+/** The table driven implementation, whatever the CPU. */
+uint32_t Crc32cPortable(const void *data, size_t len, uint32_t crc = 0);
+
+/** @return whether Crc32c uses the crc32 instruction */
+bool Crc32cIsHardwareAccelerated();
+
+#endif  // MINISQL_CRC32C_H
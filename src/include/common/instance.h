@@ -1,8 +1,11 @@
 #ifndef MINISQL_INSTANCE_H
 #define MINISQL_INSTANCE_H
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
@@ -11,21 +14,65 @@
 #include "common/macros.h"
 #include "executor/execute_context.h"
 #include "storage/disk_manager.h"
+#include "storage/table_heap.h"
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           ReplacerType replacer_type = ReplacerType::kLRU,
+                           DurabilityMode durability_mode = DurabilityMode::kPeriodic, bool direct_io = false);
 
   ~DBStorageEngine();
 
+  /**
+   * Write back every dirty page and sync the db file, everything done so far survives a crash afterwards.
+   */
+  void Checkpoint();
+
+  /**
+   * Called at the end of every statement which modified the database, checkpoints in kPerCommit durability mode.
+   * There is no log, so a commit has to write back the pages themselves.
+   */
+  void Commit();
+
   std::unique_ptr<ExecuteContext> MakeExecuteContext(Txn *txn);
 
+  /**
+   * Reclaim the space of the deleted tuples of a table and merge its sparse pages, the indexes of the table are
+   * updated with the new RowIds of the moved tuples. The caller holds latch_.
+   * @param resume if not null, vacuum at least max_pages pages from *resume on and store the page to continue from,
+   * see TableHeap::Vacuum. The caller checks that the table and its TableHeap::GetChainVersion are unchanged before
+   * passing a page stored by an earlier call back in.
+   */
+  dberr_t VacuumTable(const std::string &table_name, VacuumStats *stats, page_id_t *resume = nullptr,
+                      uint32_t max_pages = UINT32_MAX);
+
+  /**
+   * Start a thread vacuuming the tables with at least dead_tuples deleted tuples every interval_ms. It takes latch_
+   * for chunk_pages pages at a time, so that statements are not held back by the vacuum of a large table.
+   */
+  void StartAutoVacuum(uint32_t interval_ms = AUTO_VACUUM_INTERVAL_MS, uint64_t dead_tuples = AUTO_VACUUM_DEAD_TUPLES,
+                       uint32_t chunk_pages = AUTO_VACUUM_CHUNK_PAGES);
+
+  void StopAutoVacuum();
+
  public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
   std::string db_file_name_;
+  std::string dump_file_name_;  // resident pages of the buffer pool, reloaded when the database is opened again
   bool init_;
+  std::recursive_mutex latch_;  // held by a statement or a chunk of the background vacuum, execfile nests statements
+
+ private:
+  /** Vacuum the tables with enough deleted tuples, one chunk per hold of latch_. */
+  void AutoVacuumRound(uint64_t dead_tuples, uint32_t chunk_pages);
+
+  std::thread vacuum_thread_;      // background vacuum, if started
+  std::mutex vacuum_latch_;        // protects vacuum_stop_
+  std::condition_variable vacuum_cv_;
+  bool vacuum_stop_{false};
 };
 
 #endif  // MINISQL_INSTANCE_H
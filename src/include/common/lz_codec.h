@@ -0,0 +1,28 @@
+#ifndef MINISQL_LZ_CODEC_H
+#define MINISQL_LZ_CODEC_H
+
+#include <cstddef>
+
+/**
+ * A byte oriented LZ77 codec in the spirit of LZ4, made for single pages: it needs no state between calls and no
+ * memory beyond a hash table on the stack.
+ *
+ * The output is a list of sequences, each made of a token byte (the number of literals in the high nibble, the length
+ * of the match minus LZ_MIN_MATCH in the low one, 15 meaning that more length bytes follow), the literal bytes, and a
+ * 2 byte little endian offset back to the match. The last sequence has literals only.
+ */
+static constexpr size_t LZ_MIN_MATCH = 4;
+
+/**
+ * Compress len bytes of src into dst.
+ * @return the size of the compressed data, 0 if it does not fit in capacity bytes
+ */
+size_t LzCompress(const char *src, size_t len, char *dst, size_t capacity);
+
+/**
+ * Decompress len bytes of src, which must expand to exactly out_len bytes.
+ * @return false if the data is malformed
+ */
+bool LzDecompress(const char *src, size_t len, char *dst, size_t out_len);
+
+#endif  // MINISQL_LZ_CODEC_H
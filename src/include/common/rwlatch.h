@@ -1,24 +1,40 @@
 #ifndef MINISQL_RWLATCH_H
 #define MINISQL_RWLATCH_H
 
+#include <atomic>
 #include <climits>
-#include <condition_variable>
-#include <mutex>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "macros.h"
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch packed into one atomic word, 8 bytes per latch in total.
+ *
+ * The state word holds the number of readers in its low 16 bits, the number of waiting writers above them and a
+ * writer bit on top. A waiting writer keeps new readers out, so writers are preferred as with a mutex based latch.
+ * Uncontended acquisition is a single CAS, a contended one spins for a while (on multi-core machines only), yields a
+ * few times and then parks the thread on the state word with a futex (a yield loop where futexes are not available).
  */
 class ReaderWriterLatch {
-  using mutex_t = std::mutex;
-  using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
+  static constexpr uint32_t READER_MASK = 0xffff;
+  static constexpr uint32_t MAX_READERS = READER_MASK;
+  static constexpr uint32_t WAITING_WRITER = 1u << 16;
+  static constexpr uint32_t WAITING_WRITER_MASK = 0x7fff0000;
+  static constexpr uint32_t WRITER = 1u << 31;
+  static constexpr int SPIN_COUNT = 64;
+  static constexpr int YIELD_COUNT = 4;
 
  public:
   ReaderWriterLatch() = default;
 
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  ~ReaderWriterLatch() = default;
 
   DISALLOW_COPY(ReaderWriterLatch);
 
@@ -26,13 +42,20 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
+    uint32_t state = 0;
+    if (state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire)) {
+      return;
     }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
+    // Announce the writer, so that no new reader gets in, then wait for the current holders to leave.
+    state = state_.fetch_add(WAITING_WRITER, std::memory_order_relaxed) + WAITING_WRITER;
+    for (int spin = 0;; spin++) {
+      if ((state & (WRITER | READER_MASK)) == 0) {
+        if (state_.compare_exchange_weak(state, (state - WAITING_WRITER) | WRITER, std::memory_order_acquire)) {
+          return;
+        }
+        continue;
+      }
+      state = Wait(state, spin);
     }
   }
 
@@ -40,49 +63,87 @@ class ReaderWriterLatch {
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    state_.fetch_and(~WRITER);
+    WakeAll();
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    for (int spin = 0;; spin++) {
+      if ((state & (WRITER | WAITING_WRITER_MASK)) == 0 && (state & READER_MASK) < MAX_READERS) {
+        if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+          return;
+        }
+        continue;
+      }
+      state = Wait(state, spin);
     }
-    reader_count_++;
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (reader_count_ == MAX_READERS) {
-      ASSERT(false, "RUnlock failed.");
-      reader_count_ = 0;
+    uint32_t state = state_.fetch_sub(1);
+    ASSERT((state & READER_MASK) != 0, "RUnlock failed.");
+    // Only the last reader can let a writer in, and only a full latch can have readers waiting for a slot.
+    if ((state & READER_MASK) == 1 || (state & READER_MASK) == MAX_READERS) {
+      WakeAll();
     }
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
+  }
+
+ private:
+  /**
+   * Spin for a while, then park until the state word is no longer state.
+   * @return the current state word
+   */
+  uint32_t Wait(uint32_t state, int spin) {
+    static const int spin_count = std::thread::hardware_concurrency() > 1 ? SPIN_COUNT : 0;
+    if (spin < spin_count) {
+      CpuRelax();
+    } else if (spin < spin_count + YIELD_COUNT) {
+      std::this_thread::yield();
     } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
-      }
+      sleepers_.fetch_add(1);
+#ifdef __linux__
+      syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAIT_PRIVATE, state, nullptr, nullptr, 0);
+#else
+      std::this_thread::yield();
+#endif
+      sleepers_.fetch_sub(1);
     }
+    return state_.load(std::memory_order_relaxed);
   }
 
- private:
-  mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  /**
+   * Wake up the parked threads, they check the state word again. Called after every change a waiter waits for, the
+   * change and the load of sleepers_ are both sequentially consistent so that a thread about to park either sees the
+   * change or is seen here.
+   */
+  void WakeAll() {
+    if (sleepers_.load() == 0) {
+      return;
+    }
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+  }
+
+  static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free);
+
+  std::atomic<uint32_t> state_{0};     // readers, waiting writers and the writer bit
+  std::atomic<uint32_t> sleepers_{0};  // number of threads parked on state_
 };
 
 #endif  // MINISQL_RWLATCH_H
@@ -59,6 +59,10 @@ class ExecuteEngine {
 
   dberr_t ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context);
+
   dberr_t ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *context);
 
   dberr_t ExecuteDropIndex(pSyntaxNode ast, ExecuteContext *context);
@@ -73,6 +77,9 @@ class ExecuteEngine {
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
+  /** Commit the current database if a statement modifying it succeeded, see DBStorageEngine::Commit. */
+  dberr_t CommitStatement(dberr_t result);
+
   private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
@@ -1,6 +1,7 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <fstream>
 #include <queue>
 #include <string>
 #include <vector>
@@ -48,7 +49,8 @@ class BPlusTree {
   IndexIterator End();
 
   // expose for test purpose
-  Page *FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
+  // the guard holds the pin of the leaf, it is empty if a node could not be fetched
+  BasicPageGuard FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
 
   // used to check whether all pages are unpinned
   bool Check();
@@ -61,9 +63,8 @@ class BPlusTree {
       return;
     }
     out << "digraph G {" << std::endl;
-    Page *root_page = buffer_pool_manager_->FetchPage(root_page_id_);
-    auto *node = reinterpret_cast<BPlusTreePage *>(root_page->GetData());
-    ToGraph(node, buffer_pool_manager_, out, schema);
+    auto root_guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+    ToGraph(root_guard.As<BPlusTreePage>(), buffer_pool_manager_, out, schema);
     out << "}" << std::endl;
   }
 
@@ -74,9 +75,10 @@ class BPlusTree {
 
   void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction = nullptr);
 
-  LeafPage *Split(LeafPage *node, Txn *transaction);
+  // the guard holds the pin of the new page
+  BasicPageGuard Split(LeafPage *node, Txn *transaction);
 
-  InternalPage *Split(InternalPage *node, Txn *transaction);
+  BasicPageGuard Split(InternalPage *node, Txn *transaction);
 
   template <typename N>
   bool CoalesceOrRedistribute(N *&node, Txn *transaction = nullptr);
@@ -95,10 +97,10 @@ class BPlusTree {
 
   void UpdateRootPageId(int insert_record = 0);
 
-  /* Debug Routines for FREE!! */
-  void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const;
+  /* Debug Routines for FREE!! The caller holds the pin of page, the pins of its children are taken and released. */
+  void ToGraph(const BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const;
 
-  void ToString(BPlusTreePage *page, BufferPoolManager *bpm) const;
+  void ToString(const BPlusTreePage *page, BufferPoolManager *bpm) const;
 
   // member variable
   index_id_t index_id_;
@@ -107,6 +109,7 @@ class BPlusTree {
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  PageSegment segment_;  // the nodes of the tree are allocated next to each other
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
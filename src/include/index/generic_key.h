@@ -27,7 +27,7 @@ class KeyManager {
   }
 
   inline void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
-    [[maybe_unused]] uint32_t ofs = key.DeserializeFrom(const_cast<char *>(key_buf->data), schema);
+    [[maybe_unused]] uint32_t ofs = key.DeserializeFrom(key_buf->data, schema);
     ASSERT(ofs <= (uint32_t)key_size_, "Index key size exceed max key size.");
   }
 
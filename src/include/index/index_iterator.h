@@ -1,6 +1,7 @@
 #ifndef MINISQL_INDEX_ITERATOR_H
 #define MINISQL_INDEX_ITERATOR_H
 
+#include "buffer/page_guard.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 class IndexIterator {
@@ -14,8 +15,13 @@ class IndexIterator {
 
   ~IndexIterator();
 
+  // the iterator owns the pin of its current leaf, it can be moved but not copied
+  IndexIterator(IndexIterator &&that) noexcept = default;
+
+  IndexIterator &operator=(IndexIterator &&that) noexcept = default;
+
   /** Return the key/value pair this iterator is currently pointing at. */
-  std::pair<GenericKey *, RowId> operator*();
+  std::pair<const GenericKey *, RowId> operator*();
 
   /** Move to the next key/value pair.*/
   IndexIterator &operator++();
@@ -28,9 +34,10 @@ class IndexIterator {
 
  private:
   page_id_t current_page_id{INVALID_PAGE_ID};
-  LeafPage *page{nullptr};
+  const LeafPage *page{nullptr};
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
+  BasicPageGuard guard;
   // add your own private member variables here
 };
 
@@ -30,6 +30,8 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   GenericKey *KeyAt(int index);
 
+  const GenericKey *KeyAt(int index) const;
+
   void SetKeyAt(int index, GenericKey *key);
 
   int ValueIndex(const page_id_t &value) const;
@@ -42,7 +44,7 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   void PairCopy(void *dest, void *src, int pair_num = 1);
 
-  page_id_t Lookup(const GenericKey *key, const KeyManager &KP);
+  page_id_t Lookup(const GenericKey *key, const KeyManager &KP) const;
 
   void PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value);
 
@@ -70,7 +72,7 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   void CopyFirstFrom(page_id_t value, BufferPoolManager *buffer_pool_manager);
 
-  char data_[PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE];
+  char data_[PAGE_USABLE_SIZE - INTERNAL_PAGE_HEADER_SIZE];
 };
 
 using InternalPage = BPlusTreeInternalPage;
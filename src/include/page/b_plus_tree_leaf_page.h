@@ -43,13 +43,15 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   GenericKey *KeyAt(int index);
 
+  const GenericKey *KeyAt(int index) const;
+
   void SetKeyAt(int index, GenericKey *key);
 
   RowId ValueAt(int index) const;
 
   void SetValueAt(int index, RowId value);
 
-  int KeyIndex(const GenericKey *key, const KeyManager &comparator);
+  int KeyIndex(const GenericKey *key, const KeyManager &comparator) const;
 
   void *PairPtrAt(int index);
 
@@ -57,10 +59,12 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   std::pair<GenericKey *, RowId> GetItem(int index);
 
+  std::pair<const GenericKey *, RowId> GetItem(int index) const;
+
   // insert and delete methods
   int Insert(GenericKey *key, const RowId &value, const KeyManager &comparator);
 
-  bool Lookup(const GenericKey *key, RowId &value, const KeyManager &comparator);
+  bool Lookup(const GenericKey *key, RowId &value, const KeyManager &comparator) const;
 
   int RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &comparator);
 
@@ -82,7 +86,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   page_id_t next_page_id_{INVALID_PAGE_ID};
 
-  char data_[PAGE_SIZE - LEAF_PAGE_HEADER_SIZE];
+  char data_[PAGE_USABLE_SIZE - LEAF_PAGE_HEADER_SIZE];
 };
 
 using LeafPage = BPlusTreeLeafPage;
@@ -20,6 +20,18 @@ class BitmapPage {
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * Allocate the first free page in [begin, end).
+   * @param page_offset Index in extent of the page allocated.
+   * @return false if all the pages in the range are allocated.
+   */
+  bool AllocatePageInRange(uint32_t begin, uint32_t end, uint32_t &page_offset);
+
+  /**
+   * @return whether all the pages in [begin, end) are free
+   */
+  bool IsRangeFree(uint32_t begin, uint32_t end) const;
+
   /**
    * @return true if successfully de-allocate a page.
    */
@@ -40,11 +52,19 @@ class BitmapPage {
    */
   bool IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const;
 
-  /** Note: need to update if modify page structure. */
-  static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
+  /**
+   * @return the first free page at or after page_offset, or end if there is none before end
+   */
+  uint32_t FindFreePage(uint32_t page_offset, uint32_t end) const;
+
+  /** Mark a free page allocated, and move next_free_page_ past it if it was the first free page. */
+  void SetAllocated(uint32_t page_offset);
+
+  /** Note: need to update if modify page structure. The checksum of the page follows the bytes. */
+  static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t) - PAGE_CHECKSUM_SIZE;
 
  public:
-  /** The space occupied by all members of the class should be equal to the PageSize */
+  /** The space occupied by all members of the class should be equal to the PageSize, less the checksum */
   uint32_t page_allocated_;
   uint32_t next_free_page_;
   unsigned char bytes[MAX_CHARS];
@@ -5,16 +5,23 @@
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
-
+/**
+ * DiskFileMetaPage 记录数据文件的分配信息。第一个元信息页保存总页数、分区数以及前 EXTENTS_PER_META_PAGE 个分区的已用页数；
+ * 之后每 EXTENTS_PER_META_PAGE 个分区前有一个自己的元信息页，只使用其中的 extent_used_page_。
+ *
+ * | Meta Page 0 | Extent 0 | ... | Extent E-1 | Meta Page 1 | Extent E | ... | Extent 2E-1 | Meta Page 2 | ...
+ */
 class DiskFileMetaPage {
  public:
+  static constexpr uint32_t EXTENTS_PER_META_PAGE = (PAGE_USABLE_SIZE - 8) / 4;
+
   uint32_t GetExtentNums() { return num_extents_; }
 
   uint32_t GetAllocatedPages() { return num_allocated_pages_; }
 
+  /** @return the used pages of an extent counted in this page, i.e. of the extent_id-th extent of its group */
   uint32_t GetExtentUsedPage(uint32_t extent_id) {
-    if (extent_id >= num_extents_) {
+    if (extent_id >= num_extents_ || extent_id >= EXTENTS_PER_META_PAGE) {
       return 0;
     }
     return extent_used_page_[extent_id];
@@ -22,7 +29,7 @@ class DiskFileMetaPage {
 
   // 设置指定分区的已使用页数
   void SetExtentUsedPage(uint32_t extent_id, uint32_t used_pages) {
-    if (extent_id >= num_extents_) {
+    if (extent_id >= num_extents_ || extent_id >= EXTENTS_PER_META_PAGE) {
       throw std::out_of_range("Extent ID is out of range");
     }
     extent_used_page_[extent_id] = used_pages;
@@ -34,4 +41,15 @@ class DiskFileMetaPage {
   uint32_t extent_used_page_[0];
 };
 
+/**
+ * Physical page ids, which count a bitmap page per extent and a meta page per EXTENTS_PER_META_PAGE extents, are
+ * page_id_t too, this is the number of extents whose pages all have one: a bit more than 8 TiB of pages.
+ */
+static constexpr uint32_t EXTENT_PHYSICAL_PAGES = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize() + 1;
+static constexpr uint32_t MAX_EXTENTS =
+    (INT32_MAX - 2 - INT32_MAX / (DiskFileMetaPage::EXTENTS_PER_META_PAGE * EXTENT_PHYSICAL_PAGES)) /
+    EXTENT_PHYSICAL_PAGES;
+
+static constexpr page_id_t MAX_VALID_PAGE_ID = MAX_EXTENTS * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+
 #endif  // MINISQL_DISK_FILE_META_PAGE_H
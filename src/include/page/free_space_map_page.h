@@ -0,0 +1,75 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * FreeSpaceMapPage 记录一个堆表中若干页的空闲空间，以 BUCKET_SIZE 字节为单位向下取整，即 bucket 为 b 的页至少有
+ * b * BUCKET_SIZE 字节空闲。一个堆表的空闲空间页串成链表，链表的第一页还记录堆表的最后一页。
+ *
+ * Format (size in byte):
+ *  ---------------------------------------------------------------------------------------------------------------
+ * | Magic (4) | NextPageId (4) | LastPageId (4) | Count (4) | PageId_1 (4) | ... | Bucket_1 (1) | Bucket_2 (1) | ...
+ *  ---------------------------------------------------------------------------------------------------------------
+ * Slots whose PageId is INVALID_PAGE_ID are unused.
+ */
+class FreeSpaceMapPage {
+ public:
+  static constexpr uint32_t BUCKET_SIZE = 16;
+  static constexpr uint32_t CAPACITY = (PAGE_USABLE_SIZE - 16) / (sizeof(page_id_t) + 1);
+
+  void Init() {
+    magic_num_ = FREE_SPACE_MAP_MAGIC_NUM;
+    next_page_id_ = INVALID_PAGE_ID;
+    last_page_id_ = INVALID_PAGE_ID;
+    count_ = 0;
+  }
+
+  bool IsValid() const { return magic_num_ == FREE_SPACE_MAP_MAGIC_NUM && count_ <= CAPACITY; }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  page_id_t GetLastPageId() const { return last_page_id_; }
+
+  void SetLastPageId(page_id_t last_page_id) { last_page_id_ = last_page_id; }
+
+  /** @return the number of slots used so far, unused slots below it are reused first */
+  uint32_t GetCount() const { return count_; }
+
+  page_id_t GetPageId(uint32_t slot) const { return page_ids_[slot]; }
+
+  uint8_t GetBucket(uint32_t slot) const { return buckets_[slot]; }
+
+  void SetSlot(uint32_t slot, page_id_t page_id, uint8_t bucket) {
+    page_ids_[slot] = page_id;
+    buckets_[slot] = bucket;
+    if (slot >= count_) {
+      count_ = slot + 1;
+    }
+  }
+
+  /** @return the bucket of a page with free_space bytes free */
+  static uint8_t ToBucket(uint32_t free_space) {
+    return static_cast<uint8_t>(std::min<uint32_t>(free_space / BUCKET_SIZE, UINT8_MAX));
+  }
+
+ private:
+  static constexpr uint32_t FREE_SPACE_MAP_MAGIC_NUM = 0x46534d31;
+
+  uint32_t magic_num_;
+  page_id_t next_page_id_;
+  page_id_t last_page_id_;
+  uint32_t count_;
+  page_id_t page_ids_[CAPACITY];
+  uint8_t buckets_[CAPACITY];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_USABLE_SIZE);
+static_assert(PAGE_USABLE_SIZE / FreeSpaceMapPage::BUCKET_SIZE <= UINT8_MAX + 1);
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
@@ -25,14 +25,14 @@ class IndexRootsPage {
   bool Update(const index_id_t index_id, const page_id_t root_id);
 
   // return root_id if success
-  bool GetRootId(const index_id_t index_id, page_id_t *root_id);
+  bool GetRootId(const index_id_t index_id, page_id_t *root_id) const;
 
-  int GetIndexCount() { return count_; }
+  int GetIndexCount() const { return count_; }
 
  private:
-  static constexpr int MAX_INDEX_COUNT = (PAGE_SIZE - 4) / 8;
+  static constexpr int MAX_INDEX_COUNT = (PAGE_USABLE_SIZE - 4) / 8;
 
-  int FindIndex(const index_id_t index_id);
+  int FindIndex(const index_id_t index_id) const;
 
  private:
   int count_;
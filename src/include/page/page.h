@@ -1,6 +1,8 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <shared_mutex>
@@ -12,37 +14,59 @@
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data of a page is PAGE_SIZE aligned, so that it can be read and written with O_DIRECT. The frames of the buffer
+ * pool point into the data slab of their FrameTable, a page created on its own allocates its data itself.
+ *
+ * Besides the read/write latch, a page can be read optimistically: the write latch makes the version odd while it is
+ * held and even again on release, so a reader which sees the same even version before and after reading knows that
+ * no writer interfered, without writing to any shared memory itself.
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
+  friend class FrameTable;
 
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates the page data and zeros it out. */
+  Page() : Page(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)), true) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  ~Page() {
+    if (owns_data_) {
+      free(data_);
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
 
+  inline const char *GetData() const { return data_; }
+
   /** @return the page id of this page */
-  inline page_id_t GetPageId() { return page_id_; }
+  inline page_id_t GetPageId() const { return page_id_; }
 
   /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count_; }
+  inline int GetPinCount() const { return pin_count_; }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
-  inline bool IsDirty() { return is_dirty_; }
+  inline bool IsDirty() const { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_relaxed);
+    // Readers must see the odd version before any modification of the data.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -50,8 +74,48 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read.
+   * @param[out] version the version to pass to ValidateRead
+   * @return false if a writer holds the page, the read has to be retried or done under the read latch
+   */
+  inline bool TryOptimisticRead(uint64_t *version) const {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /** @return true if no writer latched the page since TryOptimisticRead returned version */
+  inline bool ValidateRead(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /**
+   * Run read on the page data optimistically, retrying up to OPTIMISTIC_READ_RETRIES times before falling back to
+   * the read latch. read may run more than once and see a torn page, only the result of its last run is consistent,
+   * and it must not trust offsets read from the page without bounds checks.
+   * @return true if an optimistic attempt succeeded, false if the read latch was taken
+   */
+  template <class Fn>
+  bool ReadOptimistic(Fn &&read) {
+    for (int i = 0; i < OPTIMISTIC_READ_RETRIES; i++) {
+      uint64_t version;
+      if (!TryOptimisticRead(&version)) {
+        continue;
+      }
+      read(static_cast<const char *>(data_));
+      if (ValidateRead(version)) {
+        return true;
+      }
+    }
+    RLatch();
+    read(static_cast<const char *>(data_));
+    RUnlatch();
+    return false;
+  }
+
   /** @return the page LSN. */
-  inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
+  inline lsn_t GetLSN() const { return *reinterpret_cast<const lsn_t *>(GetData() + OFFSET_LSN); }
 
   /** Sets the page LSN. */
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t)); }
@@ -65,19 +129,31 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /**
+   * Wrap a buffer of PAGE_SIZE bytes aligned to PAGE_SIZE, which is left untouched.
+   * @param owns_data whether the page frees the buffer when destroyed
+   */
+  Page(char *data, bool owns_data) : data_(data), owns_data_(owns_data) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_;
+  /** True if data_ was allocated by the page itself. */
+  bool owns_data_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
   int pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
+  /** True while the frame is being filled from (or written back to) disk without the buffer pool latch held. */
+  bool io_in_progress_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Bumped when the write latch is taken and released, odd while a writer holds the page. */
+  std::atomic<uint64_t> version_{0};
 };
 
 #endif  // MINISQL_PAGE_H
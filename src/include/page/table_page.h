@@ -15,6 +15,9 @@
  *  ----------------------------------------------------------------
  *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
  *  ----------------------------------------------------------------
+ *
+ *  The first page of a table heap has no previous page, its PrevPageId holds the first page of the free space map of
+ *  the heap instead, see TableHeap.
  **/
 
 #include <cstring>
@@ -31,11 +34,11 @@ class TablePage : public Page {
  public:
   void Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr, Txn *txn);
 
-  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
+  page_id_t GetTablePageId() const { return *reinterpret_cast<const page_id_t *>(GetData()); }
 
-  page_id_t GetPrevPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
+  page_id_t GetPrevPageId() const { return *reinterpret_cast<const page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
 
-  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+  page_id_t GetNextPageId() const { return *reinterpret_cast<const page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
@@ -56,37 +59,47 @@ class TablePage : public Page {
 
   void RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager);
 
-  bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
+  bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager) const;
+
+  bool GetFirstTupleRid(RowId *first_rid) const;
+
+  bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) const;
 
-  bool GetFirstTupleRid(RowId *first_rid);
+  /**
+   * Reclaim the space of the tuples marked deleted and drop the empty slots at the end. Live tuples keep their slot,
+   * so their RowId does not change.
+   * @return the number of tuples removed
+   */
+  uint32_t Vacuum(Txn *txn, LogManager *log_manager);
 
-  bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
+  /** @return the bytes the live tuples and their slots take, i.e. the space needed to move them to another page */
+  uint32_t GetUsedSpace() const;
+
+  uint32_t GetFreeSpaceRemaining() const {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
 
  private:
-  uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+  uint32_t GetFreeSpacePointer() const { return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
   void SetFreeSpacePointer(uint32_t free_space_pointer) {
     memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
   }
 
-  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+  uint32_t GetTupleCount() const { return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
 
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
-  uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
+  uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) const {
+    return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
 
   void SetTupleOffsetAtSlot(uint32_t slot_num, uint32_t offset) {
     memcpy(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num, &offset, sizeof(uint32_t));
   }
 
-  uint32_t GetTupleSize(uint32_t slot_num) {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num);
+  uint32_t GetTupleSize(uint32_t slot_num) const {
+    return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num);
   }
 
   void SetTupleSize(uint32_t slot_num, uint32_t size) {
@@ -103,7 +116,6 @@ class TablePage : public Page {
   static_assert(sizeof(page_id_t) == 4);
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
   static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
-  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
@@ -112,7 +124,8 @@ class TablePage : public Page {
   static constexpr size_t OFFSET_TUPLE_SIZE = 28;
 
  public:
-  static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
+  static constexpr size_t SIZE_TUPLE = 8;  // slot of a tuple in the header, taken by an insert besides the tuple
+  static constexpr size_t SIZE_MAX_ROW = PAGE_USABLE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
 };
 
 #endif
\ No newline at end of file
@@ -27,7 +27,7 @@
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
 %type <syntax_node> sql_insert sql_delete sql_update update_values update_value
-%type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_quit sql_exec_file sql_show_status sql_vacuum
 
 %%
 
@@ -49,6 +49,8 @@ sql:
   | sql_create_index { $$ = $1; }
   | sql_drop_index { $$ = $1; }
   | sql_show_indexes { $$ = $1; }
+  | sql_show_status { $$ = $1; }
+  | sql_vacuum { $$ = $1; }
   | sql_select { $$ = $1; }
   | sql_insert { $$ = $1; }
   | sql_delete { $$ = $1; }
@@ -195,6 +197,29 @@ sql_show_indexes:
   }
   ;
 
+/* "status" is not a keyword, so that it stays usable as a table or column name */
+sql_show_status:
+  SHOW IDENTIFIER {
+    if (strcmp($2->val_, "status") != 0) {
+      yyerror("syntax error");
+      YYERROR;
+    }
+    $$ = CreateSyntaxNode(kNodeShowStatus, NULL);
+  }
+  ;
+
+/* "vacuum" is not a keyword either */
+sql_vacuum:
+  IDENTIFIER IDENTIFIER {
+    if (strcmp($1->val_, "vacuum") != 0) {
+      yyerror("syntax error");
+      YYERROR;
+    }
+    $$ = CreateSyntaxNode(kNodeVacuum, NULL);
+    SyntaxNodeAddChildren($$, $2);
+  }
+  ;
+
 sql_select:
   SELECT select_columns FROM IDENTIFIER {
     $$ = CreateSyntaxNode(kNodeSelect, NULL);
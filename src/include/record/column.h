@@ -34,7 +34,7 @@ class Column {
 
   uint32_t GetSerializedSize() const;
 
-  static uint32_t DeserializeFrom(char *buf, Column *&column);
+  static uint32_t DeserializeFrom(const char *buf, Column *&column);
 
  private:
   static constexpr uint32_t COLUMN_MAGIC_NUM = 210928;
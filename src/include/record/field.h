@@ -91,7 +91,7 @@ class Field {
 
   inline uint32_t SerializeTo(char *buf) const { return Type::GetInstance(type_id_)->SerializeTo(*this, buf); }
 
-  inline static uint32_t DeserializeFrom(char *buf, const TypeId type_id, Field **field, bool is_null) {
+  inline static uint32_t DeserializeFrom(const char *buf, const TypeId type_id, Field **field, bool is_null) {
     return Type::GetInstance(type_id)->DeserializeFrom(buf, field, is_null);
   }
 
@@ -78,7 +78,7 @@ class Schema {
   /**
    * Only used in table
    */
-  static uint32_t DeserializeFrom(char *buf, Schema *&schema);
+  static uint32_t DeserializeFrom(const char *buf, Schema *&schema);
 
  private:
   static constexpr uint32_t SCHEMA_MAGIC_NUM = 200715;
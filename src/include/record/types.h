@@ -44,7 +44,7 @@ class Type {
   virtual uint32_t SerializeTo(const Field &field, char *buf) const;
 
   // Deserialize a field of the given type from the given storage space.
-  virtual uint32_t DeserializeFrom(char *storage, Field **field, bool is_null) const;
+  virtual uint32_t DeserializeFrom(const char *storage, Field **field, bool is_null) const;
 
   // Get serialize size of a field
   virtual uint32_t GetSerializedSize(const Field &field, bool is_null) const;
@@ -78,7 +78,7 @@ class TypeInt : public Type {
 
   virtual uint32_t SerializeTo(const Field &field, char *buf) const override;
 
-  virtual uint32_t DeserializeFrom(char *storage, Field **field, bool is_null) const override;
+  virtual uint32_t DeserializeFrom(const char *storage, Field **field, bool is_null) const override;
 
   virtual uint32_t GetSerializedSize(const Field &field, bool is_null) const override;
 
@@ -101,7 +101,7 @@ class TypeChar : public Type {
 
   virtual uint32_t SerializeTo(const Field &field, char *buf) const override;
 
-  virtual uint32_t DeserializeFrom(char *storage, Field **field, bool is_null) const override;
+  virtual uint32_t DeserializeFrom(const char *storage, Field **field, bool is_null) const override;
 
   virtual uint32_t GetSerializedSize(const Field &field, bool is_null) const override;
 
@@ -128,7 +128,7 @@ class TypeFloat : public Type {
 
   virtual uint32_t SerializeTo(const Field &field, char *buf) const override;
 
-  virtual uint32_t DeserializeFrom(char *storage, Field **field, bool is_null) const override;
+  virtual uint32_t DeserializeFrom(const char *storage, Field **field, bool is_null) const override;
 
   virtual uint32_t GetSerializedSize(const Field &field, bool is_null) const override;
 
@@ -0,0 +1,129 @@
+#ifndef MINISQL_ASYNC_IO_H
+#define MINISQL_ASYNC_IO_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * IoBatch collects page I/Os which are submitted together by DiskManager::SubmitBatch, so that a single thread keeps
+ * all of them in flight at once. A batch must not be modified nor destroyed between SubmitBatch and WaitBatch.
+ */
+class IoBatch {
+ public:
+  IoBatch() = default;
+
+  IoBatch(const IoBatch &) = delete;
+
+  IoBatch &operator=(const IoBatch &) = delete;
+
+  /** The I/O queued next only starts once the last queued one completed. */
+  inline void LinkLast() { ops_.back().linked = true; }
+
+  inline size_t Size() const { return ops_.size(); }
+
+  inline bool Empty() const { return ops_.empty(); }
+
+  inline size_t NumWrites() const { return num_writes_; }
+
+  /** Drop all the I/Os, the batch can be reused. */
+  inline void Clear() {
+    ops_.clear();
+    num_writes_ = 0;
+    pending_ = 0;
+  }
+
+ private:
+  friend class AsyncIo;
+  friend class DiskManager;
+
+  struct Op {
+    page_id_t logical_page_id;
+    page_id_t physical_page_id;
+    char *data;          // buffer read into, or the copy of source written with its checksum stamped
+    const char *source;  // page to write, never modified
+    bool is_write;
+    bool linked;
+    int result;  // bytes transferred, or -errno
+    IoBatch *batch;
+  };
+
+  std::vector<Op> ops_;
+  size_t num_writes_{0};
+  size_t pending_{0};  // I/Os submitted and not completed yet, protected by the latch of AsyncIo
+
+  std::unique_ptr<char, decltype(&free)> copies_{nullptr, &free};  // PAGE_SIZE aligned, one page per write
+  size_t copies_capacity_{0};                                       // in pages, kept by Clear for the next use
+};
+
+/**
+ * AsyncIo is a minimal io_uring ring on the db file, shared by all the threads of a DiskManager. Any thread may
+ * submit a batch, and the completions are dispatched to their batches by whichever thread waits.
+ *
+ * At most one thread sleeps in the kernel waiting for completions, the others wait on done_cv_. Completions are only
+ * reaped while no thread is in the kernel, otherwise the sleeping thread could miss the event it waits for.
+ */
+class AsyncIo {
+ public:
+  /**
+   * @param depth number of I/Os in flight at most
+   * @return nullptr if io_uring is not available, e.g. on an old kernel or when forbidden by a seccomp policy
+   */
+  static std::unique_ptr<AsyncIo> Create(int fd, uint32_t depth);
+
+  ~AsyncIo();
+
+  /** Submit all the I/Os of the batch, blocks while the ring is full. */
+  void Submit(IoBatch &batch);
+
+  /** Wait until all the I/Os of a submitted batch completed. */
+  void Wait(IoBatch &batch);
+
+ private:
+  AsyncIo() = default;
+
+  /** Block until pred holds, reaping completions meanwhile. Must be called with latch_ held. */
+  template <class Predicate>
+  void WaitUntil(std::unique_lock<std::mutex> &lock, Predicate pred);
+
+  /**
+   * Dispatch the available completions to their batches. Must be called with latch_ held.
+   * @return the number of completions reaped
+   */
+  size_t Reap();
+
+  /** Tell the kernel about count new submission queue entries. Must be called with latch_ held. */
+  void Enter(uint32_t count);
+
+  int ring_fd_{-1};
+  int fd_{-1};
+  uint32_t depth_{0};
+  // submission queue
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  struct io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  // completion queue, shares the mapping of the submission queue on recent kernels
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  struct io_uring_cqe *cqes_{nullptr};
+
+  std::mutex latch_;                 // protects the rings and the state below
+  std::condition_variable done_cv_;  // signaled when completions were reaped or the kernel waiter returned
+  size_t in_flight_{0};              // I/Os submitted and not reaped yet
+  bool waiting_in_kernel_{false};    // whether a thread sleeps in io_uring_enter
+};
+
+#endif  // MINISQL_ASYNC_IO_H
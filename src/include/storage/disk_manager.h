@@ -2,15 +2,60 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/async_io.h"
+
+/**
+ * When the writes of the DiskManager are made durable with fdatasync:
+ * kPerWrite after every page write, kPerCommit at the end of every modifying statement, kPeriodic every
+ * SYNC_INTERVAL_MS from the background writer. Close always syncs.
+ */
+enum class DurabilityMode { kPerWrite, kPerCommit, kPeriodic };
+
+/**
+ * What a read does with a page whose checksum does not match its content:
+ * kOff does not check, kWarn logs an error and counts it, kFatal aborts.
+ */
+enum class ChecksumMode { kOff, kWarn, kFatal };
+
+class DiskManager;
+
+/**
+ * PageSegment is the allocation context of a table heap or an index. It reserves runs of SEGMENT_RUN_PAGES contiguous
+ * pages and takes its pages from its current run, so that the pages of a segment lie next to each other in the file
+ * instead of being interleaved with the pages of other tables, and a scan of them turns into sequential reads.
+ *
+ * Reservations only live in memory: the pages of a run not used yet are ordinary free pages on disk, and they are
+ * given back to everyone when the run is released, i.e. when it is used up or the segment is destroyed. A segment must
+ * be destroyed before the DiskManager it allocated from.
+ */
+class PageSegment {
+ public:
+  PageSegment() = default;
+
+  ~PageSegment();
+
+  DISALLOW_COPY_AND_MOVE(PageSegment);
+
+ private:
+  friend class DiskManager;
+
+  DiskManager *disk_manager_{nullptr};   // the disk manager holding the reservation
+  page_id_t run_begin_{INVALID_PAGE_ID};  // logical page ids of the current run [run_begin_, run_end_)
+  page_id_t run_end_{INVALID_PAGE_ID};
+};
 
 /**
  * DiskManager 负责数据库中页面的分配和取消分配。它执行磁盘之间的页面读取和写入，在数据库管理系统的上下文中提供逻辑文件层。
@@ -18,10 +63,54 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ * The meta page holds the used page counts of EXTENTS_PER_META_PAGE extents (E), every following group of E extents
+ * is preceded by a meta page of its own:
+ * | Meta Page | Extent 1 | ... | Extent E | Meta Page | Extent E+1 | ... | Extent 2E | Meta Page | ...
+ * so a file holds up to MAX_VALID_PAGE_ID pages, and one of less than E extents has a single meta page.
+ *
+ * Pages are read and written with positioned pread/pwrite on a file descriptor, so data page I/O needs no lock and
+ * threads of different buffer pool instances read concurrently. db_io_latch_ only serializes the allocation
+ * metadata, i.e. the meta pages and the bitmap pages.
+ *
+ * The meta pages are all read when the file is opened, the bitmap pages are cached in memory once read, and both are
+ * written back by Sync. The extents with a free page are kept in an ordered set, allocation takes the first of them
+ * and the next free page hint of its bitmap, so it never looks at full extents, and neither AllocatePage nor
+ * IsPageFree does any I/O once the bitmap of the extent is cached. Pages allocated for a PageSegment
+ * come from runs reserved for it, the other allocations skip the reserved runs.
+ *
+ * Batches of page I/Os (ReadPageAsync, WritePageAsync, SubmitBatch, WaitBatch) are served by io_uring on Linux, so a
+ * single thread keeps all of them in flight. Where io_uring is not available the batch is executed with pread/pwrite
+ * by SubmitBatch itself.
+ *
+ * With direct_io the file is opened with O_DIRECT, so pages are cached by the buffer pool only and not a second time
+ * by the OS. O_DIRECT needs PAGE_SIZE aligned buffers: the frames of the buffer pool are, other buffers are copied
+ * through an aligned per-thread buffer (in a batch, their I/O is rejected by the kernel and redone that way).
+ * Filesystems without O_DIRECT support, e.g. tmpfs, fall back to buffered I/O.
+ *
+ * Every page written gets the CRC32C of its first PAGE_USABLE_SIZE bytes stamped in its last PAGE_CHECKSUM_SIZE
+ * bytes. The checksum goes into the copy of the page which is written, never into the caller's buffer, which may be a
+ * frame other threads are reading. Reads check it according to the ChecksumMode, so that a torn or corrupted page is
+ * reported when it is read instead of surfacing later as a crash in the code interpreting it.
+ *
+ * With page compression enabled, a page written is compressed with LzCompress and, if that saves at least one
+ * COMPRESSED_SECTOR_SIZE sector, stored in a slot of as many sectors as needed in the compressed page file
+ * <db_file>.zdata. The slot of every logical page is recorded in the page translation map <db_file>.zmap, one chunk of
+ * BITMAP_SIZE entries per extent, cached in memory and written back by Sync like the bitmaps. The home slot of a page
+ * in the db file is punched out once the page moved to the compressed file, so the file keeps its layout but takes no
+ * disk space for it. Pages written while compression is disabled, or which do not compress, go to their home slot.
+ * Free slots are kept in lists by number of sectors. A slot freed only becomes reusable, and a home slot is only
+ * punched out, after the fdatasync of the map which no longer points to it, so that a crash never leaves the map
+ * pointing to a slot overwritten or punched out. The buffer pool only ever sees uncompressed pages. While the
+ * compressed page file is open, batches are executed synchronously.
+ *
+ * Writes go to the OS without being synced, except in kPerWrite mode. The meta and bitmap pages are only written back
+ * by Sync and Close, a Sync issued while another one is running is served by the next fdatasync together with all the other
+ * waiting ones.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, DurabilityMode durability_mode = DurabilityMode::kPeriodic,
+                       bool direct_io = false);
 
   ~DiskManager() {
     if (!closed) {
@@ -41,11 +130,45 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Queue a read of the page into page_data, issued by SubmitBatch.
+   */
+  void ReadPageAsync(IoBatch &batch, page_id_t logical_page_id, char *page_data);
+
+  /**
+   * Queue a write of page_data to the page, issued by SubmitBatch. page_data must stay valid until WaitBatch returns,
+   * it is only read: the checksum is stamped into a copy owned by the batch.
+   */
+  void WritePageAsync(IoBatch &batch, page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * Issue all the I/Os queued in the batch at once.
+   */
+  void SubmitBatch(IoBatch &batch);
+
+  /**
+   * Wait for the I/Os of a submitted batch. Reads beyond the end of the file are zero-filled, and I/Os which failed or
+   * transferred less than a page are redone synchronously.
+   */
+  void WaitBatch(IoBatch &batch);
+
+  /** @return whether batches are served by io_uring */
+  inline bool IsAsyncIoEnabled() const { return async_io_ != nullptr; }
+
+  /** Serve batches with pread/pwrite from now on. No batch may be in flight. */
+  inline void DisableAsyncIo() { async_io_.reset(); }
+
   /**
    * Get next free page from disk
-   * @return logical page id of allocated page
+   * @param segment the segment the page belongs to, nullptr to take the first free page
+   * @return logical page id of allocated page, INVALID_PAGE_ID if the file is full
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(PageSegment *segment = nullptr);
+
+  /**
+   * Give the unused pages of the current run of the segment back.
+   */
+  void ReleaseSegment(PageSegment *segment);
 
   /**
    * Free this page and reset bit map
@@ -62,6 +185,39 @@ class DiskManager {
    */
   void Close();
 
+  /**
+   * Write back the meta page if needed and make all the writes issued before this call durable.
+   */
+  void Sync();
+
+  inline DurabilityMode GetDurabilityMode() const { return durability_mode_; }
+
+  inline void SetDurabilityMode(DurabilityMode durability_mode) { durability_mode_ = durability_mode; }
+
+  /** @return whether the file is opened with O_DIRECT */
+  inline bool IsDirectIo() const { return direct_io_; }
+
+  inline ChecksumMode GetChecksumMode() const { return checksum_mode_.load(std::memory_order_relaxed); }
+
+  inline void SetChecksumMode(ChecksumMode checksum_mode) { checksum_mode_ = checksum_mode; }
+
+  /** @return the number of pages read with a checksum mismatch so far */
+  inline uint64_t GetNumChecksumFailures() const { return num_checksum_failures_.load(std::memory_order_relaxed); }
+
+  /**
+   * Store the pages written from now on compressed, when they compress well enough. Pages compressed earlier remain
+   * readable whatever the setting. No batch may be in flight.
+   */
+  void SetPageCompression(bool enabled);
+
+  inline bool IsPageCompressionEnabled() const { return compression_.load(std::memory_order_relaxed); }
+
+  /** @return the number of pages stored in the compressed page file */
+  size_t GetNumCompressedPages();
+
+  /** @return the number of fdatasync calls issued so far */
+  inline uint64_t GetNumSyncs() const { return num_syncs_.load(std::memory_order_relaxed); }
+
   /**
    * Get Meta Page
    * Note: Used only for debug
@@ -69,12 +225,21 @@ class DiskManager {
   char *GetMetaData() { return meta_data_; }
 
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+  static_assert(BITMAP_SIZE % SEGMENT_RUN_PAGES == 0, "An extent must hold a whole number of segment runs.");
+  static constexpr uint32_t EXTENTS_PER_META_PAGE = DiskFileMetaPage::EXTENTS_PER_META_PAGE;
 
  private:
   /**
    * Helper function to get disk file size
    */
-  int GetFileSize(const std::string &file_name);
+  static int64_t GetFileSize(int fd);
+
+  /** @return an aligned buffer of PAGE_SIZE bytes private to the calling thread, for O_DIRECT I/O */
+  static char *BounceBuffer();
+
+  static inline bool IsAligned(const char *page_data) {
+    return reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE == 0;
+  }
 
   /**
    * Read physical page from disk
@@ -86,19 +251,183 @@ class DiskManager {
    */
   void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
+  /** Write a page where it belongs, compressed or not, without syncing it. */
+  void WriteLogicalPage(page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * Open the compressed page file and the page translation map, and load the map. The files of a former db with the
+   * same name are removed when the db file is new.
+   * @param create whether to create the files if they do not exist
+   */
+  void OpenCompressedFiles(bool create);
+
+  /**
+   * Read a page stored in the compressed page file.
+   * @return false if the page is not stored there
+   */
+  bool ReadCompressedPage(page_id_t logical_page_id, char *page_data);
+
+  /**
+   * Store a page in the compressed page file if compression is enabled and it compresses, otherwise free its slot
+   * there if it has one.
+   * @return false if the page must be written to its home slot
+   */
+  bool WriteCompressedPage(page_id_t logical_page_id, const char *page_data);
+
+  /** Forget the compressed copy of a page. Must be called with compression_latch_ held. */
+  void FreeCompressedSlot(page_id_t logical_page_id);
+
+  /** @return the first sector of a free slot of num_sectors. Must be called with compression_latch_ held. */
+  uint32_t AllocateSectors(uint32_t num_sectors);
+
+  /**
+   * Write back the dirty chunks of the page translation map. The slots freed and the home slots left before are
+   * released by ReleaseSyncedSlots once an fdatasync covers the map written.
+   */
+  void WriteBackSlotMap();
+
+  /** Make the slots freed reusable and punch out the home slots left by the maps written back up to synced_seq. */
+  void ReleaseSyncedSlots(uint64_t synced_seq);
+
+  /** Read the meta pages after the first one and collect the extents with a free page. */
+  void LoadMetaPages();
+
+  /** @return the used page count of an existing extent, in its meta page. Must be called with db_io_latch_ held. */
+  uint32_t &ExtentUsedPages(uint32_t extent_id);
+
+  /**
+   * Get the cached bitmap of an existing extent, reading it from disk the first time.
+   * Must be called with db_io_latch_ held.
+   */
+  BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id);
+
+  /** Allocate a page from the runs of the segment. Must be called with db_io_latch_ held. */
+  page_id_t AllocateSegmentPage(PageSegment *segment);
+
+  /**
+   * Reserve a run of free pages, in a new extent if no existing one has any. Must be called with db_io_latch_ held.
+   * @return the first logical page id of the run, INVALID_PAGE_ID if the file is full
+   */
+  page_id_t ReserveRun();
+
+  /**
+   * Append an empty extent. Must be called with db_io_latch_ held.
+   * @param[out] new_extent_id the id of the extent
+   * @return false if the file is full
+   */
+  bool AddExtent(uint32_t *new_extent_id);
+
+  /**
+   * Account a page just marked allocated in the bitmap of its extent. Must be called with db_io_latch_ held.
+   * @return the logical page id
+   */
+  page_id_t FinishAllocation(uint32_t extent_id, uint32_t page_offset);
+
+  static inline page_id_t GetMetaPhysicalPageId(uint32_t meta_page_index) {
+    return meta_page_index * (1 + EXTENTS_PER_META_PAGE * (BITMAP_SIZE + 1));
+  }
+
+  static inline page_id_t GetBitmapPhysicalPageId(uint32_t extent_id) {
+    return 1 + extent_id * (BITMAP_SIZE + 1) + extent_id / EXTENTS_PER_META_PAGE;
+  }
+
+  /** Store the checksum of the page in its trailer. */
+  static void StampChecksum(char *page_data);
+
+  /**
+   * Check the checksum of a page just read. A page of zeros, never written, is valid.
+   * @return false on a mismatch
+   */
+  bool VerifyChecksum(page_id_t physical_page_id, const char *page_data);
+
+  /** Count and report a page read with a wrong content, according to the ChecksumMode. */
+  void ReportCorruptPage(page_id_t physical_page_id);
+
   /**
    * Map logical page id to physical page id
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  /** Publish a new length of the file if it grew up to end. */
+  void GrowFileSize(int64_t end);
+
+  /**
+   * Record a modification of the first meta page and of the one counting the extent, which are written back now only
+   * in kPerWrite mode. Must be called with db_io_latch_ held.
+   */
+  void MarkMetaDirty(uint32_t extent_id);
+
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file
+  int db_fd_{-1};
+  // whether db_fd_ is opened with O_DIRECT
+  bool direct_io_{false};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  // length of the db file, pages at or beyond it read as zeros without a syscall
+  std::atomic<int64_t> file_size_{0};
+  // protects the meta page and the bitmap pages
   std::recursive_mutex db_io_latch_;
+  std::atomic<DurabilityMode> durability_mode_;
+  // whether the meta pages have changes not written to the file, protected by db_io_latch_
+  bool meta_dirty_{false};
+  // the meta pages after the first one, meta_data_, and whether they changed since written, protected by db_io_latch_
+  std::vector<std::unique_ptr<char[]>> meta_pages_;
+  std::vector<bool> meta_page_dirty_;
+  // cached bitmap pages by extent, nullptr if not read yet, and whether they changed since written, protected by
+  // db_io_latch_
+  std::vector<std::unique_ptr<char[]>> bitmaps_;
+  std::vector<bool> bitmap_dirty_;
+  // the extents having a free page, protected by db_io_latch_
+  std::set<uint32_t> free_extents_;
+  // first logical page ids of the runs reserved by segments, and where to look for a free run, protected by
+  // db_io_latch_
+  std::unordered_set<page_id_t> reserved_runs_;
+  uint32_t next_run_hint_{0};
+  // number of page writes issued, and the number covered by the last fdatasync
+  std::atomic<uint64_t> write_seq_{0};
+  uint64_t synced_seq_{0};
+  // serializes fdatasync calls, protects synced_seq_
+  std::mutex sync_latch_;
+  std::atomic<uint64_t> num_syncs_{0};
+  std::atomic<ChecksumMode> checksum_mode_{ChecksumMode::kWarn};
+  std::atomic<uint64_t> num_checksum_failures_{0};
+  // page compression, see above; the files are open once compressed_files_open_ is set
+  std::atomic<bool> compression_{false};
+  std::atomic<bool> compressed_files_open_{false};
+  int zdata_fd_{-1};
+  int zmap_fd_{-1};
+  // protects the compressed page state below, taken after db_io_latch_
+  std::mutex compression_latch_;
+  // slot of every logical page in the compressed page file, num_sectors_ is 0 for a page not stored there
+  struct CompressedSlot {
+    uint32_t sector_;
+    uint16_t num_sectors_;
+    uint16_t length_;
+  };
+  std::vector<CompressedSlot> slot_map_;
+  std::vector<bool> slot_map_dirty_;  // by extent
+  // first sectors of the free slots by number of sectors, and of the slots freed since the map was last written
+  std::vector<std::vector<uint32_t>> free_slots_;
+  std::vector<CompressedSlot> pending_free_slots_;
+  // pages moved from their home slot to the slot starting at sector_ since the map was last written
+  struct HomePunch {
+    page_id_t logical_page_id_;
+    uint32_t sector_;
+  };
+  std::vector<HomePunch> pending_punches_;
+  // what the maps written back free, released once the fdatasync covering write_seq_ seq_ completed
+  struct UnsyncedRelease {
+    uint64_t seq_;
+    std::vector<CompressedSlot> free_slots_;
+    std::vector<HomePunch> punches_;
+  };
+  std::deque<UnsyncedRelease> unsynced_releases_;
+  uint32_t zdata_end_sector_{0};
+  size_t num_compressed_pages_{0};
+  // io_uring ring serving the batches, nullptr to use pread/pwrite
+  std::unique_ptr<AsyncIo> async_io_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  alignas(PAGE_SIZE) char meta_data_[PAGE_SIZE];
 };
 
 #endif
\ No newline at end of file
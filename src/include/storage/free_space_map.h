@@ -0,0 +1,89 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * FreeSpaceMap keeps the free space of every page of a table heap, so that an insert goes straight to a page with
+ * room for its tuple instead of walking the page chain. It is stored in a chain of FreeSpaceMapPages, which is read
+ * once when the heap is opened and mirrored in memory, every change is written through to its page in the buffer pool.
+ * Its pages are not taken from the PageSegment of the heap, which keeps the heap pages contiguous.
+ *
+ * A page may have more free space than recorded, never less as long as every change of a page is reported. After a
+ * crash the map on disk may be older than the heap pages, it may still list a page a vacuum freed, which may since
+ * have been given to another table or an index. Load drops the entries its caller rejects with a cheap check, e.g. of
+ * the allocation bitmap, and keeps the others unchecked: the heap confirms such a page the first time it picks it, and
+ * removes it if it is not one of its pages. Remove writes the map page back before the page is freed.
+ */
+class FreeSpaceMap {
+ public:
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {}
+
+  /**
+   * Allocate the first page of an empty map.
+   * @return its page id, INVALID_PAGE_ID if the page could not be allocated
+   */
+  page_id_t Create();
+
+  /**
+   * Read the map starting at root_page_id, the entries of the pages for which is_heap_page is false are dropped, the
+   * others are unchecked.
+   * @return false if root_page_id is not the first page of a map, the map is then left empty
+   */
+  bool Load(page_id_t root_page_id, const std::function<bool(page_id_t)> &is_heap_page);
+
+  /** Record the free space of a page of the heap, adding the page if it is not in the map yet. */
+  void Update(page_id_t page_id, uint32_t free_space);
+
+  /** @return whether the entry of the page was read by Load and not confirmed by an Update since */
+  inline bool IsUnchecked(page_id_t page_id) const { return unchecked_.count(page_id) != 0; }
+
+  /** Remove a page which no longer belongs to the heap, its slot is written to disk before the page may be freed. */
+  void Remove(page_id_t page_id);
+
+  /**
+   * @return a page with at least size bytes free, the fullest of them, INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t size) const;
+
+  /** @return the last page of the page chain of the heap */
+  inline page_id_t GetLastPageId() const { return last_page_id_; }
+
+  void SetLastPageId(page_id_t last_page_id);
+
+  inline page_id_t GetRootPageId() const { return pages_.empty() ? INVALID_PAGE_ID : pages_[0]; }
+
+  inline size_t GetNumPages() const { return slots_.size(); }
+
+  /** Delete the pages of the map. */
+  void Destroy();
+
+ private:
+  struct Slot {
+    uint32_t index_;  // FreeSpaceMapPage::CAPACITY * position of its page in the chain + slot in the page
+    uint8_t bucket_;
+  };
+
+  void WriteSlot(uint32_t index, page_id_t page_id, uint8_t bucket);
+
+  void Reset();
+
+  BufferPoolManager *buffer_pool_manager_;
+  std::vector<page_id_t> pages_;                      // pages of the map in chain order
+  std::unordered_map<page_id_t, Slot> slots_;         // heap page -> its slot
+  std::set<std::pair<uint8_t, page_id_t>> by_space_;  // (bucket, heap page), ordered by free space
+  std::vector<uint32_t> free_slots_;                  // unused slots below the last used one
+  std::unordered_set<page_id_t> unchecked_;           // heap pages read by Load, not confirmed yet
+  uint32_t num_slots_{0};                             // slots used so far, including the unused ones
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
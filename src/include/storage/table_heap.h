@@ -1,13 +1,27 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <functional>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
+#include "storage/free_space_map.h"
 #include "storage/table_iterator.h"
 
+/**
+ * What a vacuum of a table heap did.
+ */
+struct VacuumStats {
+  uint32_t pages_scanned{0};
+  uint32_t tuples_removed{0};  // deleted tuples whose space was reclaimed
+  uint32_t tuples_moved{0};    // live tuples moved to another page, whose RowId changed
+  uint32_t pages_freed{0};     // pages unlinked from the heap and given back to the disk manager
+};
+
 class TableHeap {
   friend class TableIterator;
 
@@ -71,27 +85,42 @@ class TableHeap {
    */
   bool GetTuple(Row *row, Txn *txn);
 
-  void FreeTableHeap() {
-    auto next_page_id = first_page_id_;
-    while (next_page_id != INVALID_PAGE_ID) {
-      auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(old_page_id, false);
-      buffer_pool_manager_->DeletePage(old_page_id);
-    }
-  }
+  /** Called for a tuple moved by Vacuum, row carries its new RowId. */
+  using MoveCallback = std::function<void(Row &row, const RowId &old_rid)>;
+
+  /**
+   * Reclaim the space of the deleted tuples of at least max_pages pages from start on. Every page is compacted, and
+   * the next pages whose live tuples all fit in the free space of a page are merged into it and freed. A page merged
+   * while someone else pins it is only freed by a later call, and counted in stats->pages_freed then.
+   * @param start the page returned by the previous call, which is not compacted again, INVALID_PAGE_ID to start
+   * from the first page
+   * @param on_move called for every tuple moved, to update the indexes
+   * @return the page to continue from, INVALID_PAGE_ID once the end of the heap is reached
+   */
+  page_id_t Vacuum(page_id_t start, uint32_t max_pages, const MoveCallback &on_move, VacuumStats *stats, Txn *txn);
+
+  /** @return the number of tuples deleted since the last vacuum, counted since the heap was opened */
+  inline uint64_t GetNumDeadTuples() const { return num_dead_tuples_; }
+
+  /**
+   * @return a number changed whenever a page leaves the chain of the heap. A page returned by Vacuum may only be
+   * passed back as start while it did not change, otherwise the page may have been freed and even reused elsewhere.
+   */
+  inline uint64_t GetChainVersion() const { return chain_version_; }
+
+  bool FreeTableHeap() { return DeleteTable(); }
 
   /**
    * Free table heap and release storage in disk file
+   * @return false if some pages were pinned and could not be freed, calling it again retries them
    */
-  void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
+  bool DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param bulk_read whether the iterator reads through a private BufferRing instead of taking over the buffer pool
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Txn *txn);
+  TableIterator Begin(Txn *txn, bool bulk_read = false);
 
   /**
    * @return the end iterator of this table
@@ -103,6 +132,11 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the free space map of this table, every page of the heap is in it
+   */
+  inline const FreeSpaceMap &GetFreeSpaceMap() const { return free_space_map_; }
+
  private:
   /**
    * create table heap and initialize first page
@@ -112,12 +146,18 @@ class TableHeap {
       : buffer_pool_manager_(buffer_pool_manager),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {
-    auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager->NewPage(first_page_id_));
-    ASSERT(first_page != nullptr, "ERROR: cannot create firstPage in table heap, please check");
-    // 初始化页面，作为堆的首页，它的前一个页面应该是最后一页的下一个位置
-    first_page->Init(first_page_id_, PAGE_SIZE, log_manager, txn);
-    buffer_pool_manager->UnpinPage(first_page_id_, true);
+        lock_manager_(lock_manager),
+        free_space_map_(buffer_pool_manager) {
+    auto guard = buffer_pool_manager->NewPageGuarded(first_page_id_, &segment_);
+    ASSERT(guard.IsValid(), "ERROR: cannot create firstPage in table heap, please check");
+    auto page = reinterpret_cast<TablePage *>(guard.GetPageMut());
+    page->Init(first_page_id_, INVALID_PAGE_ID, log_manager, txn);
+    // 首页没有前一页，它的 PrevPageId 记录空闲空间表的第一页
+    page_id_t fsm_page_id = free_space_map_.Create();
+    ASSERT(fsm_page_id != INVALID_PAGE_ID, "ERROR: cannot create the free space map of table heap, please check");
+    page->SetPrevPageId(fsm_page_id);
+    free_space_map_.Update(first_page_id_, page->GetFreeSpaceRemaining());
+    free_space_map_.SetLastPageId(first_page_id_);
     schema_ = schema;
   };
 
@@ -127,15 +167,47 @@ class TableHeap {
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager),
+        free_space_map_(buffer_pool_manager) {
+    LoadFreeSpaceMap();
+  }
+
+  /**
+   * Read the free space map of an existing heap, or create it if the heap has none. Only the map is read, its entries
+   * are checked by InsertTuple when it picks them. The page chain is only walked to fill a new map, or when the last
+   * page recorded in the map is no longer in the chain.
+   */
+  void LoadFreeSpaceMap();
+
+  /** @return whether the page is allocated on disk, false for an invalid page id */
+  bool IsAllocated(page_id_t page_id);
+
+  /**
+   * Check a page the free space map lists without having confirmed it: it must be the first page, or a table page
+   * which is the next page of its previous page.
+   */
+  bool IsHeapPage(page_id_t page_id);
+
+  /**
+   * Append a new page after the last page of the heap.
+   * @return the guard of the new page, invalid if no page could be allocated
+   */
+  BasicPageGuard AppendPage(Txn *txn);
+
+  /** Retry DeletePage on the pages in pages_to_free_. @return the number of pages freed */
+  uint32_t FreeUnlinkedPages();
 
  private:
   BufferPoolManager *buffer_pool_manager_;
   page_id_t first_page_id_;
-  uint32_t page_num{0};
+  PageSegment segment_;  // the pages of the heap are allocated next to each other
+  uint64_t num_dead_tuples_{0};
+  uint64_t chain_version_{0};
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  FreeSpaceMap free_space_map_;
+  std::vector<page_id_t> pages_to_free_;  // unlinked from the heap, but pinned by someone else when freed
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
@@ -1,6 +1,10 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <deque>
+#include <memory>
+
+#include "buffer/buffer_ring.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
@@ -11,7 +15,8 @@ class TableIterator {
  public:
   // you may define your own constructor based on your member variables
   explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn):table_heap_(table_heap), rid(rid), txn(txn){}
-  explicit TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row);
+  explicit TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row,
+                         std::shared_ptr<BufferRing> ring = nullptr);
 
   explicit TableIterator(const TableIterator &other);
 
@@ -31,12 +36,21 @@ class TableIterator {
 
   TableIterator operator++(int);
 
+ private:
+  /**
+   * Called when the iterator enters a page during a bulk read, keeps the next READAHEAD_PAGES pages of the page chain
+   * in flight. The chain is followed through the pages which have already arrived.
+   */
+  void ReadAhead(page_id_t page_id);
+
  private:
   // add your own private member variables here
   Row *row_{nullptr};
   TableHeap *table_heap_{nullptr};
   RowId rid{INVALID_PAGE_ID, 0};
   Txn *txn;
+  std::shared_ptr<BufferRing> ring_{nullptr};  // access strategy of bulk reads, nullptr for normal access
+  std::deque<page_id_t> readahead_;            // pages prefetched ahead of the iterator, the nearest first
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
@@ -18,13 +18,10 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size) {
   LOG(INFO)<<"leaf max size: "<<leaf_max_size_<<", internal max size: "<<internal_max_size_;
-  auto index_root_page = reinterpret_cast<IndexRootsPage *>
-      (buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
-  if(!index_root_page->GetRootId(index_id, &root_page_id_)) {
+  auto roots_guard = buffer_pool_manager_->FetchPageBasic(INDEX_ROOTS_PAGE_ID);
+  if(!roots_guard.As<IndexRootsPage>()->GetRootId(index_id, &root_page_id_)) {
     root_page_id_ = INVALID_PAGE_ID;
   }
-  buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
-  buffer_pool_manager_->UnpinPage(root_page_id_, true);
 }
 /*
  * If current_page_id = INVALID_PAGE_ID, then
@@ -32,21 +29,24 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
  * destroy from the current page
  */
 void BPlusTree::Destroy(page_id_t current_page_id) {
-  if(IsEmpty()) return;
   if(current_page_id == INVALID_PAGE_ID) {
+    if(IsEmpty()) return;
     current_page_id = root_page_id_;
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId(2);
   }
-  auto page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(current_page_id)->GetData());
-  if(!page->IsLeafPage()) {
-    auto *inner = reinterpret_cast<InternalPage *>(page);
-    for(int i = page->GetSize() - 1; i >= 0; --i) {
-      Destroy(inner->ValueAt(i));
+  {
+    auto guard = buffer_pool_manager_->FetchPageBasic(current_page_id);
+    auto *page = guard.As<BPlusTreePage>();
+    if(!page->IsLeafPage()) {
+      auto *inner = guard.As<InternalPage>();
+      for(int i = page->GetSize() - 1; i >= 0; --i) {
+        Destroy(inner->ValueAt(i));
+      }
     }
   }
-  buffer_pool_manager_->DeletePage(page->GetPageId());
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  // 页必须先 unpin 才能被删除
+  buffer_pool_manager_->DeletePage(current_page_id);
 }
 
 /*
@@ -72,15 +72,14 @@ bool BPlusTree::IsEmpty() const {
  */
 bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction) {
   if(IsEmpty()) return false;
-  auto *page = FindLeafPage(key, INVALID_PAGE_ID, false);
-  if(page == nullptr) return false;
-  LeafPage *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  BasicPageGuard leaf_guard = FindLeafPage(key, INVALID_PAGE_ID, false);
+  if(!leaf_guard.IsValid()) return false;
+  auto *leaf = leaf_guard.As<LeafPage>();
   RowId val;
   bool Find = leaf->Lookup(key, val, processor_);
   if(Find) {
     result.push_back(val);
   }
-  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
   return Find;
 }
 /*****************************************************************************
@@ -117,13 +116,13 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
  * 5. 返回
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
-  auto * page = buffer_pool_manager_->NewPage(root_page_id_);
-  if(page == nullptr) {
+  auto root_guard = buffer_pool_manager_->NewPageGuarded(root_page_id_, &segment_);
+  if(!root_guard.IsValid()) {
     LOG(ERROR) << "Out of Memory";
   }
-  auto * root = reinterpret_cast<LeafPage *>(page->GetData());
+  auto * root = root_guard.AsMut<LeafPage>();
   if(leaf_max_size_ == UNDEFINED_SIZE || internal_max_size_ == UNDEFINED_SIZE){
-    leaf_max_size_ = 4064/(processor_.GetKeySize() + sizeof(value))-1;
+    leaf_max_size_ = (PAGE_USABLE_SIZE - LEAF_PAGE_HEADER_SIZE)/(processor_.GetKeySize() + sizeof(value))-1;
     internal_max_size_ =  leaf_max_size_;
     if(leaf_max_size_ < 2) {
       internal_max_size_ = 2;
@@ -132,7 +131,7 @@ void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
   }
   root->Init(root_page_id_, INVALID_PAGE_ID, processor_.GetKeySize(), leaf_max_size_);
   root->Insert(key, value, processor_);
-  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  root_guard.Drop();
   UpdateRootPageId(1);
 }
 
@@ -154,26 +153,24 @@ void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
  */
 bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction) {
   RowId _value;
-  auto * page = reinterpret_cast<LeafPage *>
-      (FindLeafPage(key, INVALID_PAGE_ID,false)->GetData());
-  int max_size = page->GetMaxSize();
-  if(page->Lookup(key,_value,processor_))
+  BasicPageGuard leaf_guard = FindLeafPage(key, INVALID_PAGE_ID, false);
+  if(leaf_guard.As<LeafPage>()->Lookup(key,_value,processor_))
   {
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
     return false;
   }
   else
   {
+    auto * page = leaf_guard.AsMut<LeafPage>();
+    int max_size = page->GetMaxSize();
     page->Insert(key,value,processor_);
     if(page->GetSize() >= max_size) {
-      auto *new_page = Split(page, transaction);
+      auto new_guard = Split(page, transaction);
+      auto *new_page = new_guard.AsMut<LeafPage>();
       new_page -> SetNextPageId(page->GetNextPageId());
 
       page->SetNextPageId(new_page->GetPageId());
       InsertIntoParent(page, new_page->KeyAt(0), new_page, transaction);
-      buffer_pool_manager_ -> UnpinPage(new_page->GetPageId(), true);
     }
-    buffer_pool_manager_ ->UnpinPage(page->GetPageId(), true);
     return true;
   }
 }
@@ -189,32 +186,32 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
  * 2. 将原来页面的一半数据移动到新的 page 中
  * 3. 返回新的page
  */
-BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
+BasicPageGuard BPlusTree::Split(InternalPage *node, Txn *transaction) {
   page_id_t new_page_id;
-  auto *page = buffer_pool_manager_->NewPage(new_page_id);
-  if(page == nullptr) {
+  auto guard = buffer_pool_manager_->NewPageGuarded(new_page_id, &segment_);
+  if(!guard.IsValid()) {
     LOG(ERROR) << "Out of memory.";
-    return nullptr;
+    return guard;
   }
-  BPlusTreeInternalPage *new_page = reinterpret_cast<InternalPage *>(page);
+  auto *new_page = guard.AsMut<InternalPage>();
   new_page->Init(new_page_id, node->GetParentPageId(),
                  node->GetKeySize(), node->GetMaxSize());
   node->MoveHalfTo(new_page, buffer_pool_manager_);
-  return new_page;
+  return guard;
 }
 
-BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
+BasicPageGuard BPlusTree::Split(LeafPage *node, Txn *transaction) {
   page_id_t new_page_id;
-  auto *page = buffer_pool_manager_->NewPage(new_page_id);
-  if(page == nullptr) {
+  auto guard = buffer_pool_manager_->NewPageGuarded(new_page_id, &segment_);
+  if(!guard.IsValid()) {
     LOG(ERROR) << "Out of memory.";
-    return nullptr;
+    return guard;
   }
-  BPlusTreeLeafPage *new_page = reinterpret_cast<LeafPage *>(page);
+  auto *new_page = guard.AsMut<LeafPage>();
 //  LOG(INFO)<<"node->GetMaxSize() "<<node->GetMaxSize();
   new_page->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(),node->GetMaxSize());
   node->MoveHalfTo(new_page);
-  return new_page;
+  return guard;
 }
 
 /*
@@ -233,27 +230,26 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
 void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node,
                                  Txn *transaction) {
   if(old_node->IsRootPage()) {
-    auto *page = buffer_pool_manager_->NewPage(root_page_id_);
-    if(page == nullptr) LOG(ERROR) << "Out of memory." << std::endl;
+    auto root_guard = buffer_pool_manager_->NewPageGuarded(root_page_id_, &segment_);
+    if(!root_guard.IsValid()) LOG(ERROR) << "Out of memory." << std::endl;
 
-    auto *new_root= reinterpret_cast<InternalPage *>(page->GetData());
+    auto *new_root= root_guard.AsMut<InternalPage>();
     new_root->Init(root_page_id_, INVALID_PAGE_ID, processor_.GetKeySize(), internal_max_size_);
     new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
     old_node->SetParentPageId(root_page_id_);
     new_node->SetParentPageId(root_page_id_);
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    root_guard.Drop();
     UpdateRootPageId(0);
   }
   else {
-    auto *parent_page = reinterpret_cast<BPlusTree::InternalPage *>(
-        buffer_pool_manager_->FetchPage(old_node->GetParentPageId())->GetData());
+    auto parent_guard = buffer_pool_manager_->FetchPageBasic(old_node->GetParentPageId());
+    auto *parent_page = parent_guard.AsMut<InternalPage>();
     parent_page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
     if (parent_page->GetSize() >= parent_page->GetMaxSize()) {
-      InternalPage *fa_split_page = Split(parent_page, transaction);
+      auto split_guard = Split(parent_page, transaction);
+      auto *fa_split_page = split_guard.AsMut<InternalPage>();
       InsertIntoParent(parent_page, fa_split_page->KeyAt(0), fa_split_page, transaction);
-      buffer_pool_manager_->UnpinPage(fa_split_page->GetPageId(), true);
     }
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
   }
 }
 
@@ -276,14 +272,13 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
  */
 void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
   if(IsEmpty()) return;
-  auto * leaf = reinterpret_cast<LeafPage *>
-      (FindLeafPage(key, INVALID_PAGE_ID,false)->GetData());
-  if(leaf == nullptr){
+  BasicPageGuard leaf_guard = FindLeafPage(key, INVALID_PAGE_ID, false);
+  if(!leaf_guard.IsValid()){
     ASSERT(false, "leaf is nullptr");
   }
+  auto * leaf = leaf_guard.AsMut<LeafPage>();
   leaf->RemoveAndDeleteRecord(key, processor_);
   CoalesceOrRedistribute(leaf, transaction);
-  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
   return;
 
 
@@ -316,23 +311,19 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
   }
   else { // 删除后 size < min_size, 需要调整
     page_id_t parent_id = node->GetParentPageId();
-    auto * parent_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->
-                                                 FetchPage(parent_id) -> GetData());
+    auto parent_guard = buffer_pool_manager_->FetchPageBasic(parent_id);
+    auto * parent_page = parent_guard.AsMut<InternalPage>();
     int index = parent_page->ValueIndex(node->GetPageId());
     int sib_index = index - 1;
     if(sib_index < 0) sib_index = index + 1;
     page_id_t sibling_id = parent_page->ValueAt(sib_index);
-    auto *sibling_node = reinterpret_cast<N *>(buffer_pool_manager_->
-                                          FetchPage(sibling_id)->GetData());
+    auto sibling_guard = buffer_pool_manager_->FetchPageBasic(sibling_id);
+    auto *sibling_node = sibling_guard.AsMut<N>();
     if(node->GetSize() + sibling_node->GetSize() >= node->GetMaxSize()) {  // 如果合并后会大于max size，就不删除，重新分配元素
       Redistribute(sibling_node, node, index);
-      buffer_pool_manager_->UnpinPage(sibling_node->GetPageId(), true);
-      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
     } else { // 如果可以直接合并，就合并
       delete_flag = 1;
       Coalesce(sibling_node, node, parent_page, index);
-      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      buffer_pool_manager_->UnpinPage(sibling_node->GetPageId(), true);
     }
   }
   return delete_flag;
@@ -398,8 +389,8 @@ bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, Inte
  */
 void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
   LOG(INFO)<<"Redistribute LeafPage";
-  auto * parent = reinterpret_cast<InternalPage *>(buffer_pool_manager_->
-                                                  FetchPage(node->GetParentPageId())->GetData());
+  auto parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  auto * parent = parent_guard.AsMut<InternalPage>();
   if(index > 0) { // 兄弟节点在左边
     LOG(INFO)<<"index: "<<index;
     neighbor_node->MoveLastToFrontOf(node);
@@ -408,11 +399,10 @@ void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index)
     neighbor_node->MoveFirstToEndOf(node);
     parent->SetKeyAt(1, neighbor_node->KeyAt(0));
   }
-  buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
 }
 void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
-  auto * parent = reinterpret_cast<BPlusTree::InternalPage *>(buffer_pool_manager_->
-                                                             FetchPage(node->GetParentPageId())->GetData());
+  auto parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  auto * parent = parent_guard.AsMut<InternalPage>();
   if(index > 0) {
     neighbor_node->MoveLastToFrontOf(node,parent->KeyAt(index), buffer_pool_manager_);
     parent->SetKeyAt(index, node->KeyAt(0));
@@ -420,7 +410,6 @@ void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, in
     neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
     parent->SetKeyAt(1, neighbor_node->KeyAt(0));
   }
-  buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
 }
 /*
  * Update root page if necessary
@@ -441,12 +430,11 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
   if (!(old_root_node->IsLeafPage()) && old_root_node->GetSize() == 1) {
     LOG(INFO)<<"111";
     auto root = reinterpret_cast<BPlusTree::InternalPage *>(old_root_node);
-    auto *child_node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_
-                                                             ->FetchPage(root->ValueAt(0))->GetData());
+    auto child_guard = buffer_pool_manager_->FetchPageBasic(root->ValueAt(0));
+    auto *child_node = child_guard.AsMut<BPlusTreePage>();
     child_node->SetParentPageId(INVALID_PAGE_ID);
     root_page_id_ = child_node->GetPageId();
     UpdateRootPageId(0);
-    buffer_pool_manager_->UnpinPage(child_node->GetPageId(), true);
     return true;
   }
   if(old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
@@ -467,10 +455,14 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin() {
-  auto *page = reinterpret_cast<LeafPage *>(FindLeafPage(nullptr, INVALID_PAGE_ID, true)->GetData());
-  page_id_t page_id = page->GetPageId();
-  buffer_pool_manager_->UnpinPage( page->GetPageId(), false);
-  return IndexIterator(page_id, buffer_pool_manager_, 0);
+  if (IsEmpty()) {
+    return End();
+  }
+  BasicPageGuard leaf_guard = FindLeafPage(nullptr, INVALID_PAGE_ID, true);
+  if (!leaf_guard.IsValid()) {
+    return End();
+  }
+  return IndexIterator(leaf_guard.PageId(), buffer_pool_manager_, 0);
 }
 
 /*
@@ -479,11 +471,15 @@ IndexIterator BPlusTree::Begin() {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin(const GenericKey *key) {
-  auto * page = reinterpret_cast<LeafPage *>(FindLeafPage(key, INVALID_PAGE_ID, false)->GetData());
-  int index = page-> KeyIndex(key, processor_);
-  page_id_t page_id = page-> GetPageId();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-  return IndexIterator(page_id, buffer_pool_manager_, index);
+  if (IsEmpty()) {
+    return End();
+  }
+  BasicPageGuard leaf_guard = FindLeafPage(key, INVALID_PAGE_ID, false);
+  if (!leaf_guard.IsValid()) {
+    return End();
+  }
+  int index = leaf_guard.As<LeafPage>()->KeyIndex(key, processor_);
+  return IndexIterator(leaf_guard.PageId(), buffer_pool_manager_, index);
 }
 
 /*
@@ -501,29 +497,26 @@ IndexIterator BPlusTree::End() {
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
- * Note: the leaf page is pinned, you need to unpin it after use.
+ * The pin of every node is handed over to its child on the way down, the returned guard holds the pin of the leaf.
  *
  * 1. 如果 page_id == INVALID_PAGE_ID，那么从根节点开始查找
  * 2. 如果 page_id != INVALID_PAGE_ID，那么从 page_id 开始查找
  * 3. 如果 leftMost == true，那么一直向左找到叶子节点
  * 4. 如果 leftMost == false，那么根据 key 找到叶子节点
- * 5. 返回叶子节点
+ * 5. 返回叶子节点，某个节点无法读入时返回空的 guard
  */
-Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
-  if(page_id == INVALID_PAGE_ID) page_id = root_page_id_;
-  auto * page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_
-                                                     ->FetchPage(page_id)->GetData());
-  while(!(page->IsLeafPage())) {
-    auto inner = reinterpret_cast<InternalPage *>(page);
-    page_id_t child_id;
-    if(leftMost) child_id = inner->ValueAt(0);
-    else child_id = inner->Lookup(key, processor_);
-    auto child_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_
-                                                            -> FetchPage(child_id)->GetData());
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    page = child_page;
-  }
-  return reinterpret_cast<Page *>(page);
+BasicPageGuard BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = root_page_id_;
+  }
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+  while (guard.IsValid() && !guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto *inner = guard.As<InternalPage>();
+    page_id_t child_id = leftMost ? inner->ValueAt(0) : inner->Lookup(key, processor_);
+    // The child is pinned before the parent is unpinned.
+    guard = buffer_pool_manager_->FetchPageBasic(child_id);
+  }
+  return guard;
 }
 
 /*
@@ -536,7 +529,8 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
  *
  */
 void BPlusTree::UpdateRootPageId(int insert_record) {
-  auto * root = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
+  auto roots_guard = buffer_pool_manager_->FetchPageBasic(INDEX_ROOTS_PAGE_ID);
+  auto * root = roots_guard.AsMut<IndexRootsPage>();
   if(insert_record == 1) {
     root->Insert(index_id_, root_page_id_);
   }
@@ -546,17 +540,16 @@ void BPlusTree::UpdateRootPageId(int insert_record) {
   else {
     root->Delete(index_id_);
   }
-  buffer_pool_manager_->UnpinPage( INDEX_ROOTS_PAGE_ID, true);
 }
 
 /**
  * This method is used for debug only, You don't need to modify
  */
-void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const {
+void BPlusTree::ToGraph(const BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const {
   std::string leaf_prefix("LEAF_");
   std::string internal_prefix("INT_");
   if (page->IsLeafPage()) {
-    auto *leaf = reinterpret_cast<LeafPage *>(page);
+    auto *leaf = reinterpret_cast<const LeafPage *>(page);
     // Print node name
     out << leaf_prefix << leaf->GetPageId();
     // Print node properties
@@ -590,7 +583,7 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
           << leaf->GetPageId() << ";\n";
     }
   } else {
-    auto *inner = reinterpret_cast<InternalPage *>(page);
+    auto *inner = reinterpret_cast<const InternalPage *>(page);
     // Print node name
     out << internal_prefix << inner->GetPageId();
     // Print node properties
@@ -625,27 +618,27 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
     }
     // Print leaves
     for (int i = 0; i < inner->GetSize(); i++) {
-      auto child_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i))->GetData());
+      auto child_guard = bpm->FetchPageBasic(inner->ValueAt(i));
+      auto *child_page = child_guard.As<BPlusTreePage>();
       ToGraph(child_page, bpm, out, schema);
       if (i > 0) {
-        auto sibling_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i - 1))->GetData());
+        auto sibling_guard = bpm->FetchPageBasic(inner->ValueAt(i - 1));
+        auto *sibling_page = sibling_guard.As<BPlusTreePage>();
         if (!sibling_page->IsLeafPage() && !child_page->IsLeafPage()) {
           out << "{rank=same " << internal_prefix << sibling_page->GetPageId() << " " << internal_prefix
               << child_page->GetPageId() << "};\n";
         }
-        bpm->UnpinPage(sibling_page->GetPageId(), false);
       }
     }
   }
-  bpm->UnpinPage(page->GetPageId(), false);
 }
 
 /**
  * This function is for debug only, you don't need to modify
  */
-void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
+void BPlusTree::ToString(const BPlusTreePage *page, BufferPoolManager *bpm) const {
   if (page->IsLeafPage()) {
-    auto *leaf = reinterpret_cast<LeafPage *>(page);
+    auto *leaf = reinterpret_cast<const LeafPage *>(page);
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
               << " next: " << leaf->GetNextPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
@@ -654,7 +647,7 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
     std::cout << std::endl;
     std::cout << std::endl;
   } else {
-    auto *internal = reinterpret_cast<InternalPage *>(page);
+    auto *internal = reinterpret_cast<const InternalPage *>(page);
     std::cout << "Internal Page: " << internal->GetPageId() << " parent: " << internal->GetParentPageId() << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
       std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i) << ",";
@@ -662,8 +655,8 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
     std::cout << std::endl;
     std::cout << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
-      ToString(reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(internal->ValueAt(i))->GetData()), bpm);
-      bpm->UnpinPage(internal->ValueAt(i), false);
+      auto child_guard = bpm->FetchPageBasic(internal->ValueAt(i));
+      ToString(child_guard.As<BPlusTreePage>(), bpm);
     }
   }
 }
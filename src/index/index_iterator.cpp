@@ -19,20 +19,18 @@ IndexIterator::IndexIterator() = default;
  */
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
-  page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+  guard = buffer_pool_manager->FetchPageBasic(current_page_id);
+  page = guard.As<LeafPage>();
 }
 
-IndexIterator::~IndexIterator() {
-  if (current_page_id != INVALID_PAGE_ID)
-    buffer_pool_manager->UnpinPage(current_page_id, false);
-}
+IndexIterator::~IndexIterator() = default;
 
 /**
  * @brief Dereferences the iterator and returns a pair of GenericKey and RowId.
  * 
- * @return std::pair<GenericKey *, RowId> The pair of GenericKey and RowId.
+ * @return std::pair<const GenericKey *, RowId> The pair of GenericKey and RowId.
  */
-std::pair<GenericKey *, RowId> IndexIterator::operator*() {
+std::pair<const GenericKey *, RowId> IndexIterator::operator*() {
   return page->GetItem(item_index);
 }
 
@@ -43,17 +41,12 @@ std::pair<GenericKey *, RowId> IndexIterator::operator*() {
  */
 IndexIterator &IndexIterator::operator++() {
   if(++item_index == page->GetSize() && page->GetNextPageId() != INVALID_PAGE_ID) {
-    auto * next_page = reinterpret_cast<::LeafPage *>
-        (buffer_pool_manager->FetchPage(page->GetNextPageId())->GetData());
     current_page_id = page->GetNextPageId();
-    buffer_pool_manager->UnpinPage(page->GetPageId(), false);
-    page = next_page;
+    // 移动赋值会先 unpin 当前叶子
+    guard = buffer_pool_manager->FetchPageBasic(current_page_id);
+    page = guard.As<LeafPage>();
     item_index = 0;
   } if(item_index == page->GetSize()) {
-    buffer_pool_manager->UnpinPage(current_page_id, false);
-    current_page_id = INVALID_PAGE_ID;
-    page = nullptr;
-    item_index = 0;
     *this = IndexIterator();
   }
   return *this;
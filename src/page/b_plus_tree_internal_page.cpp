@@ -34,6 +34,10 @@ GenericKey *InternalPage::KeyAt(int index) {
   return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
 }
 
+const GenericKey *InternalPage::KeyAt(int index) const {
+  return reinterpret_cast<const GenericKey *>(pairs_off + index * pair_size + key_off);
+}
+
 void InternalPage::SetKeyAt(int index, GenericKey *key) {
   memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
 }
@@ -71,7 +75,7 @@ void InternalPage::PairCopy(void *dest, void *src, int pair_num) {
  * 查找一个中间节点中 key 对应的子节点
  * 使用二分查找
  */
-page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
+page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) const {
   int index = 0,  right = GetSize() - 1, left = 1; // Start the search from the second key
   while(left <= right) {
     int mid = (left + right) >> 1;
@@ -170,9 +174,8 @@ void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool
   IncreaseSize(size);
   for(int i = 1; i <= size; ++i) {
     int page_id = ValueAt(GetSize() - i);
-    BPlusTreePage *child_page = reinterpret_cast<BPlusTreePage *> (buffer_pool_manager->FetchPage(page_id)->GetData());
-    child_page->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(page_id, true);
+    auto child_guard = buffer_pool_manager->FetchPageBasic(page_id);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
   }
 }
 
@@ -246,11 +249,8 @@ void InternalPage::MoveFirstToEndOf(InternalPage *recipient, GenericKey *middle_
 void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPoolManager *buffer_pool_manager) {
   SetValueAt(GetSize(), value);
   SetKeyAt(GetSize(), key);
-  auto child_page =
-      reinterpret_cast<BPlusTreePage *>
-      (buffer_pool_manager->FetchPage(value)->GetData());
-  child_page->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(value, true);
+  auto child_guard = buffer_pool_manager->FetchPageBasic(value);
+  child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
   IncreaseSize(1);
 }
 
@@ -277,9 +277,6 @@ void InternalPage::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffe
   PairCopy(PairPtrAt(1), PairPtrAt(0), GetSize());
   IncreaseSize(1);
   SetValueAt(0, value);
-  auto child_page =
-      reinterpret_cast<BPlusTreePage *>
-      (buffer_pool_manager->FetchPage(value)->GetData());
-  child_page->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(value, true);
+  auto child_guard = buffer_pool_manager->FetchPageBasic(value);
+  child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 }
\ No newline at end of file
@@ -54,7 +54,7 @@ void LeafPage::SetNextPageId(page_id_t next_page_id) {
  * NOTE: This method is only used when generating index iterator
  * 二分查找
  */
-int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
+int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) const {
   if(GetSize() == 0) {
     return 0;
   }
@@ -84,6 +84,10 @@ GenericKey *LeafPage::KeyAt(int index) {
   return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
 }
 
+const GenericKey *LeafPage::KeyAt(int index) const {
+  return reinterpret_cast<const GenericKey *>(pairs_off + index * pair_size + key_off);
+}
+
 void LeafPage::SetKeyAt(int index, GenericKey *key) {
   memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
 }
@@ -109,6 +113,8 @@ void LeafPage::PairCopy(void *dest, void *src, int pair_num) {
  */
 std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) { return {KeyAt(index), ValueAt(index)}; }
 
+std::pair<const GenericKey *, RowId> LeafPage::GetItem(int index) const { return {KeyAt(index), ValueAt(index)}; }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -153,7 +159,7 @@ void LeafPage::CopyNFrom(void *src, int size) {
  * does, then store its corresponding value in input "value" and return true.
  * If the key does not exist, then return false
  */
-bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) {
+bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) const {
   int index = KeyIndex(key, KM);
   if(index < GetSize() && KM.CompareKeys(key, KeyAt(index)) == 0) {
     value = ValueAt(index);
@@ -1,5 +1,7 @@
 #include "page/bitmap_page.h"
 
+#include <algorithm>
+
 #include "glog/logging.h"
 
 /**
@@ -13,19 +15,8 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
   // LOG(WARNING) << "max_pages: " << max_pages;
   size_t current_page_offset = next_free_page_;
   if (IsPageFree(current_page_offset)) {
-      uint32_t byte_index = current_page_offset / 8;
-      uint8_t bit_index = current_page_offset % 8;
-      bytes[byte_index] |= (1 << bit_index);  // 将该位设置为1（已分配）
-      
-      // 更新 next_free_page_ 直到找到下一个空闲页或到达起始点
-      next_free_page_ = current_page_offset + 1;
-      while (next_free_page_ < max_pages && !IsPageFree(next_free_page_)) {
-        next_free_page_++;
-        LOG(WARNING) << "next_free_page_: " << next_free_page_;
-      }
-      
+      SetAllocated(current_page_offset);
       page_offset = current_page_offset;
-      page_allocated_++;  // 更新已分配页数
       return true;
   }
 
@@ -33,6 +24,58 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
   return false;
 }
 
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePageInRange(uint32_t begin, uint32_t end, uint32_t &page_offset) {
+  uint32_t offset = FindFreePage(begin, end);
+  if (offset == end) {
+    return false;
+  }
+  SetAllocated(offset);
+  page_offset = offset;
+  return true;
+}
+
+template <size_t PageSize>
+bool BitmapPage<PageSize>::IsRangeFree(uint32_t begin, uint32_t end) const {
+  for (uint32_t offset = begin; offset < end;) {
+    if (offset % 8 == 0 && offset + 8 <= end) {
+      if (bytes[offset / 8] != 0) {
+        return false;
+      }
+      offset += 8;
+    } else {
+      if (!IsPageFree(offset)) {
+        return false;
+      }
+      offset++;
+    }
+  }
+  return true;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreePage(uint32_t page_offset, uint32_t end) const {
+  // 整字节已分配时一次跳过 8 页
+  while (page_offset < end && !IsPageFree(page_offset)) {
+    if (page_offset % 8 == 0 && bytes[page_offset / 8] == 0xff) {
+      page_offset += 8;
+    } else {
+      page_offset++;
+    }
+  }
+  return std::min(page_offset, end);
+}
+
+template <size_t PageSize>
+void BitmapPage<PageSize>::SetAllocated(uint32_t page_offset) {
+  bytes[page_offset / 8] |= (1 << (page_offset % 8));  // 将该位设置为1（已分配）
+  page_allocated_++;                                   // 更新已分配页数
+  // 分配的是第一个空闲页时，更新 next_free_page_ 直到找到下一个空闲页
+  if (page_offset == next_free_page_) {
+    next_free_page_ = FindFreePage(page_offset + 1, GetMaxSupportedSize());
+  }
+}
+
 /**
  * DONE
  */
@@ -33,7 +33,7 @@ bool IndexRootsPage::Update(const index_id_t index_id, const page_id_t root_id)
   return true;
 }
 
-bool IndexRootsPage::GetRootId(const index_id_t index_id, page_id_t *root_id) {
+bool IndexRootsPage::GetRootId(const index_id_t index_id, page_id_t *root_id) const {
   auto index = FindIndex(index_id);
   if (index == -1) {
     return false;
@@ -42,7 +42,7 @@ bool IndexRootsPage::GetRootId(const index_id_t index_id, page_id_t *root_id) {
   return true;
 }
 
-int IndexRootsPage::FindIndex(const index_id_t index_id) {
+int IndexRootsPage::FindIndex(const index_id_t index_id) const {
   for (auto i = 0; i < count_; i++) {
     if (roots_[i].first == index_id) {
       return i;
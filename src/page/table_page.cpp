@@ -7,7 +7,7 @@ void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr,
   memcpy(GetData(), &page_id, sizeof(page_id));
   SetPrevPageId(prev_id);
   SetNextPageId(INVALID_PAGE_ID);
-  SetFreeSpacePointer(PAGE_SIZE);
+  SetFreeSpacePointer(PAGE_USABLE_SIZE);
   SetTupleCount(0);
 }
 
@@ -151,7 +151,7 @@ void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manag
 }
 
 // 获取元组的数据，将其反序列化到提供的 Row 对象中。检查元组是否存在以及是否被删除。
-bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager) {
+bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager) const {
   ASSERT(row != nullptr && row->GetRowId().Get() != INVALID_ROWID.Get(), "Invalid row.");
   // Get the current slot number.
   uint32_t slot_num = row->GetRowId().GetSlotNum();
@@ -173,7 +173,7 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
 }
 
 // 查找并返回第一个有效（未被删除）的元组的 RowId。
-bool TablePage::GetFirstTupleRid(RowId *first_rid) {
+bool TablePage::GetFirstTupleRid(RowId *first_rid) const {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
     if (!IsDeleted(GetTupleSize(i))) {
@@ -186,7 +186,7 @@ bool TablePage::GetFirstTupleRid(RowId *first_rid) {
 }
 
 // 查找并返回当前 RowId 之后的第一个有效（未被删除）的元组的 RowId。用于遍历元组。
-bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
+bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) const {
   ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
   // Find and return the first valid tuple after our current slot number.
   for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); i++) {
@@ -199,3 +199,33 @@ bool TablePage::GetNextTupleRid(const RowId &cur_rid, RowId *next_rid) {
   next_rid->Set(INVALID_PAGE_ID, 0);
   return false;
 }
+
+// 回收所有被标记删除的元组所占的空间，并去掉末尾的空槽。存活元组的槽号不变。
+uint32_t TablePage::Vacuum(Txn *txn, LogManager *log_manager) {
+  uint32_t num_removed = 0;
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (tuple_size != 0 && IsDeleted(tuple_size)) {
+      ApplyDelete(RowId(GetTablePageId(), i), txn, log_manager);
+      num_removed++;
+    }
+  }
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  SetTupleCount(tuple_count);
+  return num_removed;
+}
+
+// 存活元组的数据及其槽所占的空间。
+uint32_t TablePage::GetUsedSpace() const {
+  uint32_t used = 0;
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (!IsDeleted(tuple_size)) {
+      used += tuple_size + SIZE_TUPLE;
+    }
+  }
+  return used;
+}
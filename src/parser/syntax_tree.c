@@ -170,6 +170,10 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowStatus:
+      return "kNodeShowStatus";
+    case kNodeVacuum:
+      return "kNodeVacuum";
     default:
       return "error type";
   }
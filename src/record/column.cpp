@@ -86,11 +86,11 @@ uint32_t Column::GetSerializedSize() const {
 /**
  * DONE
  */
-uint32_t Column::DeserializeFrom(char *buf, Column *&column) {
+uint32_t Column::DeserializeFrom(const char *buf, Column *&column) {
   /* deserialize field from buf */
 
   void *mem = malloc(sizeof(Column));
-  char *p = buf;
+  const char *p = buf;
 
   // COLUMN_MAGIC_NUM
   uint32_t magic_num = MACH_READ_UINT32(buf);
@@ -36,10 +36,10 @@ uint32_t Row::SerializeTo(char *buf, Schema *schema) const {
 /**
  * DONE
  */
-uint32_t Row::DeserializeFrom(char *buf, Schema *schema) {
+uint32_t Row::DeserializeFrom(const char *buf, Schema *schema) {
   ASSERT(schema != nullptr, "Invalid schema before serialize.");
   ASSERT(fields_.empty(), "Non empty field in row.");
-  char *p = buf;
+  const char *p = buf;
 
   // rid
   uint32_t page_id = MACH_READ_UINT32(buf);
@@ -14,7 +14,7 @@ uint32_t Schema::SerializeTo(char *buf) const {
   char *begin = buf;
 
   uint32_t ofs = GetSerializedSize();
-  ASSERT(ofs <= PAGE_SIZE, "Failed to serialize schema.");
+  ASSERT(ofs <= PAGE_USABLE_SIZE, "Failed to serialize schema.");
 
   // SCHEMA_MAGIC_NUM
   MACH_WRITE_UINT32(buf, SCHEMA_MAGIC_NUM);
@@ -46,8 +46,8 @@ uint32_t Schema::GetSerializedSize() const {
 /**
  * DONE
  */
-uint32_t Schema::DeserializeFrom(char *buf, Schema *&schema) {
-    char *start = buf;
+uint32_t Schema::DeserializeFrom(const char *buf, Schema *&schema) {
+    const char *start = buf;
     // SCHEMA_MAGIC_NUM
     uint32_t magic_num = MACH_READ_UINT32(buf);
     buf += sizeof(uint32_t);
@@ -24,7 +24,7 @@ uint32_t Type::SerializeTo(const Field &field, char *buf) const {
   return 0;
 }
 
-uint32_t Type::DeserializeFrom(char *storage, Field **field, bool is_null) const {
+uint32_t Type::DeserializeFrom(const char *storage, Field **field, bool is_null) const {
   ASSERT(false, "DeserializeFrom not implemented.");
   return 0;
 }
@@ -84,7 +84,7 @@ uint32_t TypeInt::SerializeTo(const Field &field, char *buf) const {
   return 0;
 }
 
-uint32_t TypeInt::DeserializeFrom(char *storage, Field **field, bool is_null) const {
+uint32_t TypeInt::DeserializeFrom(const char *storage, Field **field, bool is_null) const {
   if (is_null) {
     *field = new Field(TypeId::kTypeInt);
     return 0;
@@ -159,7 +159,7 @@ uint32_t TypeFloat::SerializeTo(const Field &field, char *buf) const {
   return 0;
 }
 
-uint32_t TypeFloat::DeserializeFrom(char *storage, Field **field, bool is_null) const {
+uint32_t TypeFloat::DeserializeFrom(const char *storage, Field **field, bool is_null) const {
   if (is_null) {
     *field = new Field(TypeId::kTypeFloat);
     return 0;
@@ -235,13 +235,14 @@ uint32_t TypeChar::SerializeTo(const Field &field, char *buf) const {
   return 0;
 }
 
-uint32_t TypeChar::DeserializeFrom(char *storage, Field **field, bool is_null) const {
+uint32_t TypeChar::DeserializeFrom(const char *storage, Field **field, bool is_null) const {
   if (is_null) {
     *field = new Field(TypeId::kTypeChar);
     return 0;
   }
   uint32_t len = MACH_READ_UINT32(storage);
-  *field = new Field(TypeId::kTypeChar, storage + sizeof(uint32_t), len, true);
+  // The field copies the chars, storage is not written through the pointer.
+  *field = new Field(TypeId::kTypeChar, const_cast<char *>(storage + sizeof(uint32_t)), len, true);
   return len + sizeof(uint32_t);
 }
 
@@ -0,0 +1,229 @@
+#include "storage/async_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "glog/logging.h"
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+
+namespace {
+int IoUringSetup(uint32_t entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+/** The ring indexes are shared with the kernel, they are accessed as atomics. */
+inline unsigned LoadAcquire(unsigned *p) {
+  return reinterpret_cast<std::atomic<unsigned> *>(p)->load(std::memory_order_acquire);
+}
+
+inline void StoreRelease(unsigned *p, unsigned v) {
+  reinterpret_cast<std::atomic<unsigned> *>(p)->store(v, std::memory_order_release);
+}
+}  // namespace
+
+std::unique_ptr<AsyncIo> AsyncIo::Create(int fd, uint32_t depth) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = IoUringSetup(depth, &params);
+  if (ring_fd < 0) {
+    LOG(INFO) << "io_uring unavailable (" << strerror(errno) << "), using pread/pwrite";
+    return nullptr;
+  }
+  std::unique_ptr<AsyncIo> io(new AsyncIo());
+  io->ring_fd_ = ring_fd;
+  io->fd_ = fd;
+  io->depth_ = params.sq_entries;
+  io->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  io->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    io->sq_ring_size_ = io->cq_ring_size_ = std::max(io->sq_ring_size_, io->cq_ring_size_);
+  }
+  io->sq_ring_ = mmap(nullptr, io->sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                      IORING_OFF_SQ_RING);
+  if (io->sq_ring_ == MAP_FAILED) {
+    io->sq_ring_ = nullptr;
+    return nullptr;
+  }
+  if (single_mmap) {
+    io->cq_ring_ = io->sq_ring_;
+  } else {
+    io->cq_ring_ = mmap(nullptr, io->cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                        IORING_OFF_CQ_RING);
+    if (io->cq_ring_ == MAP_FAILED) {
+      io->cq_ring_ = nullptr;
+      return nullptr;
+    }
+  }
+  io->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, io->sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                    IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return nullptr;
+  }
+  io->sqes_ = static_cast<io_uring_sqe *>(sqes);
+  auto *sq = static_cast<char *>(io->sq_ring_);
+  io->sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  io->sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  io->sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  io->sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(io->cq_ring_);
+  io->cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  io->cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  io->cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  io->cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  return io;
+}
+
+AsyncIo::~AsyncIo() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    WaitUntil(lock, [this]() { return in_flight_ == 0; });
+  }
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+/**
+ * 1. 环满时先等待其他 I/O 完成
+ * 2. 填写 SQE，linked 的 I/O 带 IOSQE_IO_LINK，使下一个 I/O 在其完成后才开始
+ * 3. 一次 io_uring_enter 提交所有新的 SQE
+ */
+void AsyncIo::Submit(IoBatch &batch) {
+  std::unique_lock<std::mutex> lock(latch_);
+  batch.pending_ = batch.ops_.size();
+  uint32_t queued = 0;
+  for (size_t i = 0; i < batch.ops_.size(); i++) {
+    auto &op = batch.ops_[i];
+    op.batch = &batch;
+    // A chain of linked I/Os must be queued in one go, wait for room for all of it at its first I/O.
+    size_t chain = 0;
+    if (i == 0 || !batch.ops_[i - 1].linked) {
+      chain = 1;
+      while (i + chain < batch.ops_.size() && batch.ops_[i + chain - 1].linked) {
+        chain++;
+      }
+    }
+    if (in_flight_ + queued + chain > depth_) {
+      Enter(queued);
+      queued = 0;
+      WaitUntil(lock, [this, chain]() { return in_flight_ + chain <= depth_; });
+    }
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe &sqe = sqes_[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = op.is_write ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe.fd = fd_;
+    sqe.off = static_cast<uint64_t>(op.physical_page_id) * PAGE_SIZE;
+    sqe.addr = reinterpret_cast<uint64_t>(op.data);
+    sqe.len = PAGE_SIZE;
+    sqe.user_data = reinterpret_cast<uint64_t>(&op);
+    if (op.linked && i + 1 < batch.ops_.size()) {
+      sqe.flags |= IOSQE_IO_LINK;
+    }
+    sq_array_[index] = index;
+    StoreRelease(sq_tail_, tail + 1);
+    queued++;
+  }
+  Enter(queued);
+}
+
+void AsyncIo::Enter(uint32_t count) {
+  in_flight_ += count;
+  while (count > 0) {
+    int submitted = IoUringEnter(ring_fd_, count, 0, 0);
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        // The completion queue is full, make room unless the thread in the kernel is about to do it.
+        if (!waiting_in_kernel_) {
+          Reap();
+        }
+        continue;
+      }
+      LOG(FATAL) << "io_uring_enter failed: " << strerror(errno);
+    }
+    count -= submitted;
+  }
+}
+
+void AsyncIo::Wait(IoBatch &batch) {
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitUntil(lock, [&batch]() { return batch.pending_ == 0; });
+}
+
+template <class Predicate>
+void AsyncIo::WaitUntil(std::unique_lock<std::mutex> &lock, Predicate pred) {
+  while (!pred()) {
+    if (waiting_in_kernel_) {
+      done_cv_.wait(lock);
+      continue;
+    }
+    if (Reap() > 0) {
+      continue;
+    }
+    waiting_in_kernel_ = true;
+    lock.unlock();
+    int rc = IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+    if (rc < 0 && errno != EINTR) {
+      LOG(FATAL) << "io_uring_enter failed: " << strerror(errno);
+    }
+    lock.lock();
+    waiting_in_kernel_ = false;
+    Reap();
+    done_cv_.notify_all();
+  }
+}
+
+size_t AsyncIo::Reap() {
+  unsigned head = *cq_head_;
+  unsigned tail = LoadAcquire(cq_tail_);
+  size_t reaped = 0;
+  for (; head != tail; head++) {
+    io_uring_cqe &cqe = cqes_[head & cq_mask_];
+    auto *op = reinterpret_cast<IoBatch::Op *>(cqe.user_data);
+    op->result = cqe.res;
+    op->batch->pending_--;
+    reaped++;
+  }
+  if (reaped > 0) {
+    StoreRelease(cq_head_, head);
+    in_flight_ -= reaped;
+    done_cv_.notify_all();
+  }
+  return reaped;
+}
+
+#else
+
+std::unique_ptr<AsyncIo> AsyncIo::Create(int fd, uint32_t depth) { return nullptr; }
+
+AsyncIo::~AsyncIo() = default;
+
+void AsyncIo::Submit(IoBatch &batch) {}
+
+void AsyncIo::Wait(IoBatch &batch) {}
+
+#endif
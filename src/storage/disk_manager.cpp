@@ -1,215 +1,815 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <filesystem>
 #include <stdexcept>
 
+#include "common/crc32c.h"
+#include "common/lz_codec.h"
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+namespace {
+constexpr uint32_t SECTORS_PER_PAGE = PAGE_SIZE / COMPRESSED_SECTOR_SIZE;
+// a compressed page must save at least a sector
+constexpr size_t MAX_COMPRESSED_SIZE = (SECTORS_PER_PAGE - 1) * COMPRESSED_SECTOR_SIZE;
+
+/** pread or pwrite all of len bytes, retrying on EINTR and short transfers. */
+template <class Io, class Buffer>
+bool TransferAll(Io io, int fd, Buffer buffer, size_t len, off_t offset) {
+  size_t done = 0;
+  while (done < len) {
+    ssize_t rc = io(fd, buffer + done, len - done, offset + done);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return false;
+    }
+    done += rc;
+  }
+  return true;
+}
+}  // namespace
+
+DiskManager::DiskManager(const std::string &db_file, DurabilityMode durability_mode, bool direct_io)
+    : file_name_(db_file), durability_mode_(durability_mode) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    std::filesystem::path p = db_file;
-    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw std::exception();
+  // create the directory if it does not exist, the file itself is created by open
+  std::filesystem::path p = db_file;
+  if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT, 0666);
+    direct_io_ = db_fd_ >= 0;
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG(WARNING) << "O_DIRECT is not supported for " << db_file << ", using buffered I/O";
     }
   }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  }
+  if (db_fd_ < 0) {
+    throw std::exception();
+  }
+  file_size_ = GetFileSize(db_fd_);
   ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  LoadMetaPages();
+  OpenCompressedFiles(false);
+  async_io_ = AsyncIo::Create(db_fd_, ASYNC_IO_DEPTH);
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    Sync();
+    async_io_.reset();
+    close(db_fd_);
+    db_fd_ = -1;
+    if (compressed_files_open_) {
+      close(zdata_fd_);
+      close(zmap_fd_);
+      zdata_fd_ = zmap_fd_ = -1;
+      compressed_files_open_ = false;
+    }
     closed = true;
   }
 }
 
+/**
+ * 数据页的读写使用 pread/pwrite，不依赖共享的文件指针，因此无需持有 db_io_latch_
+ */
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
+  if (compressed_files_open_.load(std::memory_order_acquire) && ReadCompressedPage(logical_page_id, page_data)) {
+    return;
+  }
   ReadPhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
-  WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  WriteLogicalPage(logical_page_id, page_data);
+  if (durability_mode_ == DurabilityMode::kPerWrite) {
+    Sync();
+  }
 }
 
-/**
- * DONE
- */
-page_id_t DiskManager::AllocatePage() {
-  DiskFileMetaPage* metaPage = reinterpret_cast<DiskFileMetaPage*>(GetMetaData());
-  uint32_t total_extents = metaPage->GetExtentNums();
-  uint32_t num_allocated_pages_ = metaPage->GetAllocatedPages();
-  uint32_t extents_id = 0;
-
-  
-
-
-  // 找到最近一个没有满的分区
-  while(metaPage->extent_used_page_[extents_id] == BitmapPage<PAGE_SIZE>::GetMaxSupportedSize() && extents_id < total_extents) extents_id++;
-  uint32_t bitmapPageId = 1 + extents_id * (BITMAP_SIZE + 1);
-  if (extents_id == total_extents) { // 如果所有分区都满了
-      auto new_extent = new BitmapPage<PAGE_SIZE>();
-      // LOG(WARNING) << "WritePhysicalPage bitmapPageId_: " << bitmapPageId;
-      WritePhysicalPage(bitmapPageId, reinterpret_cast<char *>(new_extent));
-      metaPage->extent_used_page_[total_extents] = 0;
-      metaPage->num_extents_++;
-      total_extents++;
-  }
-  // LOG(WARNING) << "bitmapPageId: " << bitmapPageId;
-  
-  
-  auto bitmap = new BitmapPage<PAGE_SIZE>();
-  
-  // 更新元信息页
-
-
-  ReadPhysicalPage(bitmapPageId, reinterpret_cast<char*>(bitmap));
-  
-  uint32_t page_offset = 0;
-  // LOG(WARNING) << "next_free_page_: " << bitmap->next_free_page_;
-  // LOG(WARNING) << "page_allocated_: " << bitmap->page_allocated_;
-  
-
-  bitmap->AllocatePage(page_offset);
+void DiskManager::WriteLogicalPage(page_id_t logical_page_id, const char *page_data) {
+  if (compressed_files_open_.load(std::memory_order_acquire) &&
+      WriteCompressedPage(logical_page_id, page_data)) {
+    return;
+  }
+  WritePhysicalPage(MapPageId(logical_page_id), page_data);
+}
 
-  WritePhysicalPage(bitmapPageId, reinterpret_cast<char *>(bitmap));
-  metaPage->num_allocated_pages_++;
-  metaPage->extent_used_page_[extents_id]++;
-  
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
+void DiskManager::ReadPageAsync(IoBatch &batch, page_id_t logical_page_id, char *page_data) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  batch.ops_.push_back({logical_page_id, MapPageId(logical_page_id), page_data, nullptr, false, false, 0, &batch});
+}
 
+void DiskManager::WritePageAsync(IoBatch &batch, page_id_t logical_page_id, const char *page_data) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  batch.ops_.push_back({logical_page_id, MapPageId(logical_page_id), nullptr, page_data, true, false, 0, &batch});
+  batch.num_writes_++;
+}
 
-  // 计算并返回逻辑页号
-  return extents_id * BITMAP_SIZE + page_offset; // 逻辑页号不包含位图页
+/**
+ * 单个 I/O 直接用 pread/pwrite 完成，与 io_uring 相比省去一次系统调用。
+ * 异步写的是页的副本，校验和盖在副本上：调用方的缓冲区可能是仍有读者的帧，不能改写
+ */
+void DiskManager::SubmitBatch(IoBatch &batch) {
+  if (async_io_ != nullptr && batch.Size() > 1 && !compressed_files_open_.load(std::memory_order_acquire)) {
+    if (batch.copies_capacity_ < batch.NumWrites()) {
+      batch.copies_.reset(static_cast<char *>(aligned_alloc(PAGE_SIZE, batch.NumWrites() * PAGE_SIZE)));
+      batch.copies_capacity_ = batch.NumWrites();
+    }
+    char *copy = batch.copies_.get();
+    for (auto &op : batch.ops_) {
+      if (op.is_write) {
+        memcpy(copy, op.source, PAGE_USABLE_SIZE);
+        StampChecksum(copy);
+        op.data = copy;
+        copy += PAGE_SIZE;
+      }
+    }
+    async_io_->Submit(batch);
+    return;
+  }
+  for (auto &op : batch.ops_) {
+    if (op.is_write) {
+      WriteLogicalPage(op.logical_page_id, op.source);
+    } else {
+      ReadPage(op.logical_page_id, op.data);
+    }
+    op.result = PAGE_SIZE;
+  }
+  batch.pending_ = 0;
 }
 
+void DiskManager::WaitBatch(IoBatch &batch) {
+  if (batch.pending_ > 0) {
+    async_io_->Wait(batch);
+    for (auto &op : batch.ops_) {
+      if (op.result == PAGE_SIZE) {
+        if (op.is_write) {
+          write_seq_.fetch_add(1);
+          GrowFileSize(static_cast<int64_t>(op.physical_page_id + 1) * PAGE_SIZE);
+        } else {
+          VerifyChecksum(op.physical_page_id, op.data);
+        }
+        continue;
+      }
+      // 读到文件末尾之外的部分补零，其余失败或不完整的 I/O 同步重做
+      int64_t offset = static_cast<int64_t>(op.physical_page_id) * PAGE_SIZE;
+      if (!op.is_write && op.result >= 0 && offset + op.result >= file_size_.load(std::memory_order_acquire)) {
+        memset(op.data + op.result, 0, PAGE_SIZE - op.result);
+        VerifyChecksum(op.physical_page_id, op.data);
+      } else if (op.is_write) {
+        WritePhysicalPage(op.physical_page_id, op.source);
+      } else {
+        ReadPhysicalPage(op.physical_page_id, op.data);
+      }
+    }
+  }
+  if (batch.NumWrites() > 0 && durability_mode_ == DurabilityMode::kPerWrite) {
+    Sync();
+  }
+}
 
+/**
+ * 组提交：等待 sync_latch_ 期间，若正在进行的 fdatasync 已覆盖本次调用之前的所有写，则直接返回；
+ * 否则由拿到锁的线程发起一次 fdatasync，覆盖所有已发出的写
+ */
+void DiskManager::Sync() {
+  {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    if (closed) {
+      return;
+    }
+    if (meta_dirty_) {
+      // 位图页先于元信息页写回
+      for (uint32_t extent_id = 0; extent_id < bitmaps_.size(); extent_id++) {
+        if (bitmap_dirty_[extent_id]) {
+          WritePhysicalPage(GetBitmapPhysicalPageId(extent_id), bitmaps_[extent_id].get());
+          bitmap_dirty_[extent_id] = false;
+        }
+      }
+      for (uint32_t i = 0; i < meta_pages_.size(); i++) {
+        if (meta_page_dirty_[i]) {
+          WritePhysicalPage(GetMetaPhysicalPageId(i + 1), meta_pages_[i].get());
+          meta_page_dirty_[i] = false;
+        }
+      }
+      // 第一个元信息页最后写回，其中的分区数覆盖的分区都已写回
+      WritePhysicalPage(META_PAGE_ID, meta_data_);
+      meta_dirty_ = false;
+    }
+    // 页映射表在释放页时修改，但不一定修改元信息页
+    if (compressed_files_open_) {
+      WriteBackSlotMap();
+    }
+  }
+  uint64_t target = write_seq_.load();
+  std::lock_guard<std::mutex> lock(sync_latch_);
+  if (synced_seq_ >= target) {
+    return;
+  }
+  uint64_t seq = write_seq_.load();
+  if (fdatasync(db_fd_) != 0 ||
+      (compressed_files_open_ && (fdatasync(zdata_fd_) != 0 || fdatasync(zmap_fd_) != 0))) {
+    LOG(ERROR) << "I/O error while syncing: " << strerror(errno);
+    return;
+  }
+  num_syncs_.fetch_add(1, std::memory_order_relaxed);
+  synced_seq_ = seq;
+  if (compressed_files_open_) {
+    ReleaseSyncedSlots(seq);
+  }
+}
 
+void DiskManager::MarkMetaDirty(uint32_t extent_id) {
+  meta_dirty_ = true;
+  if (extent_id >= EXTENTS_PER_META_PAGE) {
+    meta_page_dirty_[extent_id / EXTENTS_PER_META_PAGE - 1] = true;
+  }
+  if (durability_mode_ == DurabilityMode::kPerWrite) {
+    Sync();
+  }
+}
 
+PageSegment::~PageSegment() {
+  if (disk_manager_ != nullptr) {
+    disk_manager_->ReleaseSegment(this);
+  }
+}
 
 /**
- * DONE
+ * 1. 按顺序遍历有空闲页的分区，跳过被段预留的页组；所有分区都满了则新建一个分区
+ * 2. 在缓存的位图中按 next_free_page_ 分配页，位图和元信息页在 Sync 时写回
  */
-void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
-  LOG(WARNING) << "DeAllocatePage: ";
-  DiskFileMetaPage* metaPage = reinterpret_cast<DiskFileMetaPage*>(GetMetaData());
-
-  int extents_id = logical_page_id / BITMAP_SIZE; // 计算分区索引
-  int page_offset = logical_page_id % BITMAP_SIZE; // 计算分区内的页位置
-
-  int bitmapPageId = 1 + extents_id * (BITMAP_SIZE + 1); // 计算位图页的物理页号
+page_id_t DiskManager::AllocatePage(PageSegment *segment) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (segment != nullptr) {
+    return AllocateSegmentPage(segment);
+  }
+  for (uint32_t extent_id : free_extents_) {
+    BitmapPage<PAGE_SIZE> *bitmap = GetBitmap(extent_id);
+    uint32_t page_offset = 0;
+    if (reserved_runs_.empty()) {
+      bool allocated = bitmap->AllocatePage(page_offset);
+      ASSERT(allocated, "Bitmap page and meta page disagree.");
+      return FinishAllocation(extent_id, page_offset);
+    }
+    for (uint32_t begin = bitmap->next_free_page_; begin < BITMAP_SIZE;) {
+      uint32_t run_end = begin / SEGMENT_RUN_PAGES * SEGMENT_RUN_PAGES + SEGMENT_RUN_PAGES;
+      if (reserved_runs_.find(extent_id * BITMAP_SIZE + run_end - SEGMENT_RUN_PAGES) == reserved_runs_.end() &&
+          bitmap->AllocatePageInRange(begin, run_end, page_offset)) {
+        return FinishAllocation(extent_id, page_offset);
+      }
+      begin = run_end;
+    }
+  }
+  uint32_t extent_id;
+  if (!AddExtent(&extent_id)) {
+    return INVALID_PAGE_ID;
+  }
+  uint32_t page_offset = 0;
+  GetBitmap(extent_id)->AllocatePage(page_offset);
+  return FinishAllocation(extent_id, page_offset);
+}
 
-  auto bitmap = new BitmapPage<PAGE_SIZE>();
-  ReadPhysicalPage(bitmapPageId, reinterpret_cast<char*>(bitmap));
+/**
+ * 1. 在段当前预留的页组中分配第一个空闲页，段内释放的页也会被重新使用
+ * 2. 页组用完后释放它，从 next_run_hint_ 开始找一个完全空闲且未被预留的页组，没有则新建一个分区
+ * 3. 无法新建分区时退回普通分配
+ */
+page_id_t DiskManager::AllocateSegmentPage(PageSegment *segment) {
+  segment->disk_manager_ = this;
+  while (true) {
+    if (segment->run_begin_ != INVALID_PAGE_ID) {
+      uint32_t extent_id = segment->run_begin_ / BITMAP_SIZE;
+      uint32_t base = extent_id * BITMAP_SIZE;
+      uint32_t page_offset = 0;
+      if (GetBitmap(extent_id)->AllocatePageInRange(segment->run_begin_ - base, segment->run_end_ - base,
+                                                    page_offset)) {
+        return FinishAllocation(extent_id, page_offset);
+      }
+      ReleaseSegment(segment);
+    }
+    page_id_t run_begin = ReserveRun();
+    if (run_begin == INVALID_PAGE_ID) {
+      return AllocatePage(nullptr);
+    }
+    segment->run_begin_ = run_begin;
+    segment->run_end_ = run_begin + SEGMENT_RUN_PAGES;
+  }
+}
 
-  if (!bitmap->IsPageFree(page_offset)) {
-    bitmap->DeAllocatePage(page_offset);
+page_id_t DiskManager::ReserveRun() {
+  for (auto it = free_extents_.lower_bound(next_run_hint_ / BITMAP_SIZE); it != free_extents_.end(); ++it) {
+    uint32_t extent_id = *it;
+    if (ExtentUsedPages(extent_id) + SEGMENT_RUN_PAGES > BITMAP_SIZE) {
+      continue;
+    }
+    BitmapPage<PAGE_SIZE> *bitmap = GetBitmap(extent_id);
+    uint32_t base = extent_id * BITMAP_SIZE;
+    uint32_t begin = std::max<uint32_t>(next_run_hint_, base) - base;
+    for (begin = begin / SEGMENT_RUN_PAGES * SEGMENT_RUN_PAGES; begin < BITMAP_SIZE; begin += SEGMENT_RUN_PAGES) {
+      if (reserved_runs_.find(base + begin) == reserved_runs_.end() &&
+          bitmap->IsRangeFree(begin, begin + SEGMENT_RUN_PAGES)) {
+        next_run_hint_ = base + begin + SEGMENT_RUN_PAGES;
+        reserved_runs_.insert(base + begin);
+        return base + begin;
+      }
+    }
+  }
+  uint32_t extent_id;
+  if (!AddExtent(&extent_id)) {
+    return INVALID_PAGE_ID;
+  }
+  next_run_hint_ = extent_id * BITMAP_SIZE + SEGMENT_RUN_PAGES;
+  reserved_runs_.insert(extent_id * BITMAP_SIZE);
+  return extent_id * BITMAP_SIZE;
+}
 
-    WritePhysicalPage(bitmapPageId, reinterpret_cast<const char*>(bitmap));
+void DiskManager::ReleaseSegment(PageSegment *segment) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (segment->run_begin_ == INVALID_PAGE_ID) {
+    return;
+  }
+  // 页组中未使用的页本就是空闲页，释放后即可被其他段或普通分配使用
+  reserved_runs_.erase(segment->run_begin_);
+  next_run_hint_ = std::min(next_run_hint_, static_cast<uint32_t>(segment->run_begin_));
+  segment->run_begin_ = segment->run_end_ = INVALID_PAGE_ID;
+}
 
+bool DiskManager::AddExtent(uint32_t *new_extent_id) {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(GetMetaData());
+  uint32_t extent_id = meta_page->GetExtentNums();
+  if (extent_id >= MAX_EXTENTS) {
+    LOG(ERROR) << "The database file is full.";
+    return false;
+  }
+  // 每 EXTENTS_PER_META_PAGE 个分区的第一个分区之前是一个新的元信息页
+  if (extent_id / EXTENTS_PER_META_PAGE > meta_pages_.size()) {
+    meta_pages_.emplace_back(new char[PAGE_SIZE]());
+    meta_page_dirty_.push_back(true);
+  }
+  // 新分区的位图全部空闲，无需从磁盘读取
+  if (bitmaps_.size() <= extent_id) {
+    bitmaps_.resize(extent_id + 1);
+    bitmap_dirty_.resize(extent_id + 1);
+  }
+  bitmaps_[extent_id].reset(new char[PAGE_SIZE]());
+  bitmap_dirty_[extent_id] = true;
+  meta_page->num_extents_++;
+  ExtentUsedPages(extent_id) = 0;
+  free_extents_.insert(extent_id);
+  MarkMetaDirty(extent_id);
+  *new_extent_id = extent_id;
+  return true;
+}
 
+page_id_t DiskManager::FinishAllocation(uint32_t extent_id, uint32_t page_offset) {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(GetMetaData());
+  bitmap_dirty_[extent_id] = true;
+  meta_page->num_allocated_pages_++;
+  if (++ExtentUsedPages(extent_id) == BITMAP_SIZE) {
+    free_extents_.erase(extent_id);
+  }
+  MarkMetaDirty(extent_id);
+  // 计算并返回逻辑页号
+  return extent_id * BITMAP_SIZE + page_offset;  // 逻辑页号不包含位图页
+}
 
+void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(GetMetaData());
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;    // 计算分区索引
+  uint32_t page_offset = logical_page_id % BITMAP_SIZE;  // 计算分区内的页位置
+  if (extent_id >= meta_page->GetExtentNums()) {
+    return;
+  }
+  if (GetBitmap(extent_id)->DeAllocatePage(page_offset)) {
+    if (compressed_files_open_) {
+      std::scoped_lock<std::mutex> compression_lock(compression_latch_);
+      FreeCompressedSlot(logical_page_id);
+    }
+    bitmap_dirty_[extent_id] = true;
     // 更新元信息页
-    DiskFileMetaPage* metaPage = reinterpret_cast<DiskFileMetaPage*>(GetMetaData());
-    metaPage->num_allocated_pages_--;
-    metaPage->extent_used_page_[extents_id]--;
-    WritePhysicalPage(META_PAGE_ID, meta_data_);
+    meta_page->num_allocated_pages_--;
+    ExtentUsedPages(extent_id)--;
+    free_extents_.insert(extent_id);
+    uint32_t run_begin = static_cast<uint32_t>(logical_page_id) / SEGMENT_RUN_PAGES * SEGMENT_RUN_PAGES;
+    next_run_hint_ = std::min(next_run_hint_, run_begin);
+    MarkMetaDirty(extent_id);
   }
 }
 
-
-
-
-/**
- * DONE
- */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
-  if(logical_page_id >= MAX_VALID_PAGE_ID)//逻辑页号不合法
+  if (logical_page_id < 0 || logical_page_id >= MAX_VALID_PAGE_ID) {  // 逻辑页号不合法
     return false;
-  int extents_id = logical_page_id / BITMAP_SIZE;
-  int page_offset = logical_page_id % BITMAP_SIZE;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (extent_id >= reinterpret_cast<DiskFileMetaPage *>(GetMetaData())->GetExtentNums()) {
+    return true;
+  }
+  return GetBitmap(extent_id)->IsPageFree(logical_page_id % BITMAP_SIZE);
+}
 
-  int bitmapPageId = 1 + extents_id * (BITMAP_SIZE + 1);
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmap(uint32_t extent_id) {
+  if (bitmaps_.size() <= extent_id) {
+    bitmaps_.resize(extent_id + 1);
+    bitmap_dirty_.resize(extent_id + 1);
+  }
+  if (bitmaps_[extent_id] == nullptr) {
+    bitmaps_[extent_id].reset(new char[PAGE_SIZE]());
+    ReadPhysicalPage(GetBitmapPhysicalPageId(extent_id), bitmaps_[extent_id].get());
+  }
+  return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmaps_[extent_id].get());
+}
 
-  // Reading the bitmap page from disk
-  BitmapPage<PAGE_SIZE> bitmap;
-  ReadPhysicalPage(bitmapPageId, reinterpret_cast<char*>(&bitmap));
+uint32_t &DiskManager::ExtentUsedPages(uint32_t extent_id) {
+  uint32_t index = extent_id / EXTENTS_PER_META_PAGE;
+  char *meta_page = index == 0 ? meta_data_ : meta_pages_[index - 1].get();
+  return reinterpret_cast<DiskFileMetaPage *>(meta_page)->extent_used_page_[extent_id % EXTENTS_PER_META_PAGE];
+}
 
-  // Check if the page is free
-  return bitmap.IsPageFree(page_offset);
+void DiskManager::LoadMetaPages() {
+  uint32_t num_extents = reinterpret_cast<DiskFileMetaPage *>(meta_data_)->GetExtentNums();
+  uint32_t num_meta_pages = (num_extents + EXTENTS_PER_META_PAGE - 1) / EXTENTS_PER_META_PAGE;
+  for (uint32_t index = 1; index < num_meta_pages; index++) {
+    meta_pages_.emplace_back(new char[PAGE_SIZE]());
+    meta_page_dirty_.push_back(false);
+    ReadPhysicalPage(GetMetaPhysicalPageId(index), meta_pages_.back().get());
+  }
+  for (uint32_t extent_id = 0; extent_id < num_extents; extent_id++) {
+    if (ExtentUsedPages(extent_id) < BITMAP_SIZE) {
+      free_extents_.insert(extent_id);
+    }
+  }
 }
 
 /**
- * DONE
+ * 逻辑页号之前的每个分区有一个位图页，每 EXTENTS_PER_META_PAGE 个分区有一个元信息页
  */
-page_id_t DiskManager::MapPageId(page_id_t logical_page_id) { //将逻辑页号转换成物理页号
-  uint32_t extent_meta_page_num = (logical_page_id / BITMAP_SIZE + 1);
-  uint32_t total_extra_meta_page_num = extent_meta_page_num + 1;
-  return total_extra_meta_page_num + logical_page_id;
+page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  return logical_page_id + extent_id + 2 + extent_id / EXTENTS_PER_META_PAGE;
 }
+static_assert(static_cast<int64_t>(MAX_VALID_PAGE_ID - 1) + MAX_EXTENTS + 1 +
+                      (MAX_EXTENTS - 1) / DiskFileMetaPage::EXTENTS_PER_META_PAGE <=
+                  INT32_MAX,
+              "The physical page ids of the valid pages must fit in page_id_t.");
 
 
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(int fd) {
   struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
+  int rc = fstat(fd, &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
 }
 
+char *DiskManager::BounceBuffer() {
+  thread_local std::unique_ptr<char, decltype(&free)> buffer(static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE)),
+                                                             &free);
+  return buffer.get();
+}
+
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
+  off_t offset = static_cast<off_t>(physical_page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (offset >= file_size_.load(std::memory_order_acquire)) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
     memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    
-
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG(INFO) << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    return;
+  }
+  // O_DIRECT 要求缓冲区对齐，未对齐的缓冲区经由线程私有的对齐缓冲区中转
+  char *target = direct_io_ && !IsAligned(page_data) ? BounceBuffer() : page_data;
+  ssize_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t rc = pread(db_fd_, target + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      LOG(ERROR) << "I/O error while reading: " << strerror(errno);
+    }
+    if (rc <= 0) {
+      break;
     }
+    read_count += rc;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG(INFO) << "Read less than a page" << std::endl;
+    memset(target + read_count, 0, PAGE_SIZE - read_count);
+  }
+  if (target != page_data) {
+    memcpy(page_data, target, PAGE_SIZE);
   }
+  VerifyChecksum(physical_page_id, page_data);
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
+  // The checksum is stamped into a private copy: the caller may be a frame still pinned by others, the bytes written
+  // and those the checksum covers must be the same.
+  char *copy = BounceBuffer();
+  memcpy(copy, page_data, PAGE_SIZE);
+  StampChecksum(copy);
+  page_data = copy;
+  off_t offset = static_cast<off_t>(physical_page_id) * PAGE_SIZE;
+  ssize_t written = 0;
+  while (written < PAGE_SIZE) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, PAGE_SIZE - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (rc < 0) {
+      LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+      return;
+    }
+    written += rc;
+  }
+  write_seq_.fetch_add(1);
+  GrowFileSize(offset + PAGE_SIZE);
+}
 
-  // if(physical_page_id == 1){
-  //   const BitmapPage<PAGE_SIZE> *bitmap_page = reinterpret_cast<const BitmapPage<PAGE_SIZE> *>(page_data);
-  //   LOG(INFO) << "BitmapPage next_free_page_: " << bitmap_page->next_free_page_;
-  // }
+void DiskManager::StampChecksum(char *page_data) {
+  uint32_t checksum = Crc32c(page_data, PAGE_USABLE_SIZE);
+  memcpy(page_data + PAGE_USABLE_SIZE, &checksum, PAGE_CHECKSUM_SIZE);
+}
 
+/**
+ * 全零的页从未被写过（文件空洞或预分配的部分），视为有效
+ */
+bool DiskManager::VerifyChecksum(page_id_t physical_page_id, const char *page_data) {
+  ChecksumMode mode = checksum_mode_.load(std::memory_order_relaxed);
+  if (mode == ChecksumMode::kOff) {
+    return true;
+  }
+  uint32_t stored;
+  memcpy(&stored, page_data + PAGE_USABLE_SIZE, PAGE_CHECKSUM_SIZE);
+  if (Crc32c(page_data, PAGE_USABLE_SIZE) == stored) {
+    return true;
+  }
+  if (stored == 0 && std::all_of(page_data, page_data + PAGE_USABLE_SIZE, [](char c) { return c == 0; })) {
+    return true;
+  }
+  ReportCorruptPage(physical_page_id);
+  return false;
+}
 
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
+void DiskManager::ReportCorruptPage(page_id_t physical_page_id) {
+  num_checksum_failures_.fetch_add(1, std::memory_order_relaxed);
+  if (checksum_mode_.load(std::memory_order_relaxed) == ChecksumMode::kFatal) {
+    LOG(FATAL) << "Checksum mismatch in physical page " << physical_page_id << " of " << file_name_;
+  }
+  LOG(ERROR) << "Checksum mismatch in physical page " << physical_page_id << " of " << file_name_;
+}
+
+void DiskManager::GrowFileSize(int64_t end) {
+  // the file may have grown, publish its new length to the readers
+  int64_t size = file_size_.load(std::memory_order_relaxed);
+  while (size < end && !file_size_.compare_exchange_weak(size, end, std::memory_order_release)) {
+  }
+}
+
+void DiskManager::SetPageCompression(bool enabled) {
+  if (enabled && !compressed_files_open_) {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    OpenCompressedFiles(true);
+  }
+  compression_ = enabled && compressed_files_open_;
+}
+
+size_t DiskManager::GetNumCompressedPages() {
+  std::scoped_lock<std::mutex> lock(compression_latch_);
+  return num_compressed_pages_;
+}
+
+/**
+ * 加载整个页映射表，已用的槽之间的空隙按不超过 SECTORS_PER_PAGE - 1 个扇区切分后放入空闲链表
+ */
+void DiskManager::OpenCompressedFiles(bool create) {
+  std::string zdata_name = file_name_ + ".zdata";
+  std::string zmap_name = file_name_ + ".zmap";
+  if (file_size_ == 0) {
+    unlink(zdata_name.c_str());
+    unlink(zmap_name.c_str());
+  }
+  int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0);
+  zmap_fd_ = open(zmap_name.c_str(), flags, 0666);
+  if (zmap_fd_ < 0) {
+    if (create) {
+      LOG(ERROR) << "Cannot open " << zmap_name << ": " << strerror(errno);
+    }
+    return;
+  }
+  zdata_fd_ = open(zdata_name.c_str(), flags | O_CREAT, 0666);
+  if (zdata_fd_ < 0) {
+    LOG(ERROR) << "Cannot open " << zdata_name << ": " << strerror(errno);
+    close(zmap_fd_);
+    zmap_fd_ = -1;
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
-}
\ No newline at end of file
+  std::scoped_lock<std::mutex> lock(compression_latch_);
+  int64_t map_size = GetFileSize(zmap_fd_);
+  slot_map_.assign(map_size / sizeof(CompressedSlot), CompressedSlot{0, 0, 0});
+  if (!TransferAll(pread, zmap_fd_, reinterpret_cast<char *>(slot_map_.data()),
+                   slot_map_.size() * sizeof(CompressedSlot), 0)) {
+    LOG(ERROR) << "I/O error while reading " << zmap_name;
+  }
+  slot_map_dirty_.assign((slot_map_.size() + BITMAP_SIZE - 1) / BITMAP_SIZE, false);
+  free_slots_.assign(SECTORS_PER_PAGE, {});
+  std::vector<CompressedSlot> used;
+  for (const auto &slot : slot_map_) {
+    if (slot.num_sectors_ != 0) {
+      used.push_back(slot);
+    }
+  }
+  num_compressed_pages_ = used.size();
+  std::sort(used.begin(), used.end(), [](const auto &a, const auto &b) { return a.sector_ < b.sector_; });
+  uint32_t end = 0;
+  for (const auto &slot : used) {
+    while (end < slot.sector_) {
+      uint32_t gap = std::min(slot.sector_ - end, SECTORS_PER_PAGE - 1);
+      free_slots_[gap].push_back(end);
+      end += gap;
+    }
+    end = std::max(end, slot.sector_ + slot.num_sectors_);
+  }
+  zdata_end_sector_ = end;
+  compressed_files_open_.store(true, std::memory_order_release);
+}
+
+bool DiskManager::ReadCompressedPage(page_id_t logical_page_id, char *page_data) {
+  CompressedSlot slot{0, 0, 0};
+  {
+    std::scoped_lock<std::mutex> lock(compression_latch_);
+    if (static_cast<size_t>(logical_page_id) < slot_map_.size()) {
+      slot = slot_map_[logical_page_id];
+    }
+  }
+  if (slot.num_sectors_ == 0) {
+    return false;
+  }
+  char *buffer = BounceBuffer();
+  if (!TransferAll(pread, zdata_fd_, buffer, slot.num_sectors_ * COMPRESSED_SECTOR_SIZE,
+                   static_cast<off_t>(slot.sector_) * COMPRESSED_SECTOR_SIZE)) {
+    LOG(ERROR) << "I/O error while reading a compressed page: " << strerror(errno);
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  if (!LzDecompress(buffer, slot.length_, page_data, PAGE_SIZE)) {
+    // 不返回解压到一半的页
+    memset(page_data, 0, PAGE_SIZE);
+    ReportCorruptPage(MapPageId(logical_page_id));
+    return true;
+  }
+  VerifyChecksum(MapPageId(logical_page_id), page_data);
+  return true;
+}
+
+/**
+ * 扇区数不变时原地覆盖，否则另分配一个槽。旧槽的重用和原位置的打洞都要等指向新位置的页映射表
+ * 写回并 fdatasync 之后，否则崩溃后页映射表仍指向已被覆盖的旧槽或已打洞的原位置
+ */
+bool DiskManager::WriteCompressedPage(page_id_t logical_page_id, const char *page_data) {
+  char *buffer = BounceBuffer();
+  size_t length = 0;
+  if (compression_.load(std::memory_order_relaxed)) {
+    // 与 WritePhysicalPage 一样在副本上加校验和
+    char page[PAGE_SIZE];
+    memcpy(page, page_data, PAGE_SIZE);
+    StampChecksum(page);
+    length = LzCompress(page, PAGE_SIZE, buffer, MAX_COMPRESSED_SIZE);
+  }
+  std::unique_lock<std::mutex> lock(compression_latch_);
+  if (length == 0) {
+    FreeCompressedSlot(logical_page_id);
+    return false;
+  }
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (slot_map_.size() <= static_cast<size_t>(logical_page_id)) {
+    slot_map_.resize((extent_id + 1) * BITMAP_SIZE, CompressedSlot{0, 0, 0});
+    slot_map_dirty_.resize(extent_id + 1);
+  }
+  CompressedSlot &slot = slot_map_[logical_page_id];
+  bool moved = slot.num_sectors_ == 0;
+  auto num_sectors = static_cast<uint16_t>((length + COMPRESSED_SECTOR_SIZE - 1) / COMPRESSED_SECTOR_SIZE);
+  if (slot.num_sectors_ != num_sectors) {
+    FreeCompressedSlot(logical_page_id);
+    slot.sector_ = AllocateSectors(num_sectors);
+    slot.num_sectors_ = num_sectors;
+    num_compressed_pages_++;
+  }
+  slot.length_ = static_cast<uint16_t>(length);
+  slot_map_dirty_[extent_id] = true;
+  if (moved) {
+    pending_punches_.push_back({logical_page_id, slot.sector_});
+  }
+  off_t offset = static_cast<off_t>(slot.sector_) * COMPRESSED_SECTOR_SIZE;
+  lock.unlock();
+  memset(buffer + length, 0, num_sectors * COMPRESSED_SECTOR_SIZE - length);
+  if (!TransferAll(pwrite, zdata_fd_, static_cast<const char *>(buffer), num_sectors * COMPRESSED_SECTOR_SIZE,
+                   offset)) {
+    LOG(ERROR) << "I/O error while writing a compressed page: " << strerror(errno);
+  }
+  write_seq_.fetch_add(1);
+  return true;
+}
+
+void DiskManager::FreeCompressedSlot(page_id_t logical_page_id) {
+  if (slot_map_.size() <= static_cast<size_t>(logical_page_id) || slot_map_[logical_page_id].num_sectors_ == 0) {
+    return;
+  }
+  CompressedSlot &slot = slot_map_[logical_page_id];
+  pending_free_slots_.push_back(slot);
+  slot.num_sectors_ = 0;
+  slot_map_dirty_[logical_page_id / BITMAP_SIZE] = true;
+  num_compressed_pages_--;
+}
+
+/**
+ * 优先使用大小正好的空闲槽，其次切分更大的空闲槽，都没有时在文件末尾追加
+ */
+uint32_t DiskManager::AllocateSectors(uint32_t num_sectors) {
+  for (uint32_t size = num_sectors; size < SECTORS_PER_PAGE; size++) {
+    if (!free_slots_[size].empty()) {
+      uint32_t sector = free_slots_[size].back();
+      free_slots_[size].pop_back();
+      if (size > num_sectors) {
+        free_slots_[size - num_sectors].push_back(sector + num_sectors);
+      }
+      return sector;
+    }
+  }
+  uint32_t sector = zdata_end_sector_;
+  zdata_end_sector_ += num_sectors;
+  return sector;
+}
+
+/**
+ * 写回后的槽释放和打洞记下本次写回的序号，覆盖该序号的 fdatasync 之后由 ReleaseSyncedSlots 执行
+ */
+void DiskManager::WriteBackSlotMap() {
+  std::scoped_lock<std::mutex> lock(compression_latch_);
+  constexpr size_t chunk_size = BITMAP_SIZE * sizeof(CompressedSlot);
+  for (uint32_t extent_id = 0; extent_id < slot_map_dirty_.size(); extent_id++) {
+    if (!slot_map_dirty_[extent_id]) {
+      continue;
+    }
+    if (!TransferAll(pwrite, zmap_fd_, reinterpret_cast<const char *>(slot_map_.data() + extent_id * BITMAP_SIZE),
+                     chunk_size, static_cast<off_t>(extent_id) * chunk_size)) {
+      LOG(ERROR) << "I/O error while writing the page translation map: " << strerror(errno);
+      return;
+    }
+    slot_map_dirty_[extent_id] = false;
+  }
+  if (pending_free_slots_.empty() && pending_punches_.empty()) {
+    return;
+  }
+  unsynced_releases_.push_back({write_seq_.fetch_add(1) + 1, std::move(pending_free_slots_),
+                                std::move(pending_punches_)});
+  pending_free_slots_.clear();
+  pending_punches_.clear();
+}
+
+/**
+ * 打洞前确认页仍在同一个槽中：期间页若写回了原位置，其映射已改变，原位置不能再打洞。
+ * 槽本身在下一次 fdatasync 之前不会被重新分配，所以扇区相同即说明页从未离开过
+ */
+void DiskManager::ReleaseSyncedSlots(uint64_t synced_seq) {
+  std::scoped_lock<std::mutex> lock(compression_latch_);
+  while (!unsynced_releases_.empty() && unsynced_releases_.front().seq_ <= synced_seq) {
+    auto &release = unsynced_releases_.front();
+    for (const auto &slot : release.free_slots_) {
+      free_slots_[slot.num_sectors_].push_back(slot.sector_);
+    }
+    for (const auto &punch : release.punches_) {
+      const CompressedSlot &slot = slot_map_[punch.logical_page_id_];
+      off_t home = static_cast<off_t>(MapPageId(punch.logical_page_id_)) * PAGE_SIZE;
+      if (slot.num_sectors_ == 0 || slot.sector_ != punch.sector_ ||
+          home >= file_size_.load(std::memory_order_acquire)) {
+        continue;
+      }
+      // 页的原位置不再使用，打洞释放其磁盘空间；文件系统不支持时页仍可读，只是不省空间
+      if (fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, home, PAGE_SIZE) != 0 &&
+          errno != EOPNOTSUPP) {
+        LOG(WARNING) << "Cannot punch out the home slot of page " << punch.logical_page_id_ << ": "
+                     << strerror(errno);
+      }
+    }
+    unsynced_releases_.pop_front();
+  }
+}
@@ -0,0 +1,155 @@
+#include "storage/free_space_map.h"
+
+page_id_t FreeSpaceMap::Create() {
+  page_id_t root_page_id;
+  auto guard = buffer_pool_manager_->NewPageGuarded(root_page_id);
+  if (!guard.IsValid()) {
+    return INVALID_PAGE_ID;
+  }
+  guard.AsMut<FreeSpaceMapPage>()->Init();
+  pages_.assign(1, root_page_id);
+  return root_page_id;
+}
+
+/**
+ * 沿链表读入所有空闲空间页，重建内存中的映射，空槽位记入 free_slots_ 供复用
+ * 不属于堆表的页（崩溃前被 vacuum 释放而空闲空间表未写回）的槽位清空后写回
+ */
+bool FreeSpaceMap::Load(page_id_t root_page_id, const std::function<bool(page_id_t)> &is_heap_page) {
+  std::vector<uint32_t> stale_slots;
+  for (page_id_t page_id = root_page_id; page_id != INVALID_PAGE_ID;) {
+    auto guard = buffer_pool_manager_->FetchPageRead(page_id);
+    if (!guard.IsValid() || !guard.As<FreeSpaceMapPage>()->IsValid()) {
+      Reset();
+      return false;
+    }
+    auto page = guard.As<FreeSpaceMapPage>();
+    if (pages_.empty()) {
+      last_page_id_ = page->GetLastPageId();
+    }
+    // 只有最后一页可以不满，前面的页的空槽位都记为未使用
+    num_slots_ = pages_.size() * FreeSpaceMapPage::CAPACITY;
+    for (uint32_t slot = 0; slot < page->GetCount(); slot++) {
+      uint32_t index = num_slots_ + slot;
+      page_id_t heap_page_id = page->GetPageId(slot);
+      if (heap_page_id == INVALID_PAGE_ID) {
+        free_slots_.push_back(index);
+        continue;
+      }
+      if (!is_heap_page(heap_page_id) || slots_.count(heap_page_id) != 0) {
+        stale_slots.push_back(index);
+        continue;
+      }
+      slots_[heap_page_id] = {index, page->GetBucket(slot)};
+      by_space_.emplace(page->GetBucket(slot), heap_page_id);
+      unchecked_.insert(heap_page_id);
+    }
+    num_slots_ += page->GetCount();
+    if (page->GetNextPageId() != INVALID_PAGE_ID) {
+      for (uint32_t slot = page->GetCount(); slot < FreeSpaceMapPage::CAPACITY; slot++) {
+        free_slots_.push_back(pages_.size() * FreeSpaceMapPage::CAPACITY + slot);
+      }
+    }
+    pages_.push_back(page_id);
+    page_id = page->GetNextPageId();
+  }
+  // 持有读 latch 时不能写同一页，读完后再清空
+  for (uint32_t index : stale_slots) {
+    WriteSlot(index, INVALID_PAGE_ID, 0);
+    free_slots_.push_back(index);
+  }
+  return !pages_.empty();
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, uint32_t free_space) {
+  unchecked_.erase(page_id);
+  uint8_t bucket = FreeSpaceMapPage::ToBucket(free_space);
+  auto it = slots_.find(page_id);
+  if (it != slots_.end()) {
+    if (it->second.bucket_ == bucket) {
+      return;
+    }
+    by_space_.erase({it->second.bucket_, page_id});
+    it->second.bucket_ = bucket;
+    by_space_.emplace(bucket, page_id);
+    WriteSlot(it->second.index_, page_id, bucket);
+    return;
+  }
+  uint32_t index;
+  if (!free_slots_.empty()) {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    index = num_slots_++;
+  }
+  slots_[page_id] = {index, bucket};
+  by_space_.emplace(bucket, page_id);
+  WriteSlot(index, page_id, bucket);
+}
+
+void FreeSpaceMap::Remove(page_id_t page_id) {
+  unchecked_.erase(page_id);
+  auto it = slots_.find(page_id);
+  if (it == slots_.end()) {
+    return;
+  }
+  by_space_.erase({it->second.bucket_, page_id});
+  WriteSlot(it->second.index_, INVALID_PAGE_ID, 0);
+  buffer_pool_manager_->FlushPage(pages_[it->second.index_ / FreeSpaceMapPage::CAPACITY]);
+  free_slots_.push_back(it->second.index_);
+  slots_.erase(it);
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) const {
+  // 向上取整，保证 bucket 对应的空闲空间不小于 size
+  uint32_t bucket = (size + FreeSpaceMapPage::BUCKET_SIZE - 1) / FreeSpaceMapPage::BUCKET_SIZE;
+  if (bucket > UINT8_MAX) {
+    return INVALID_PAGE_ID;
+  }
+  auto it = by_space_.lower_bound({static_cast<uint8_t>(bucket), INT32_MIN});
+  return it == by_space_.end() ? INVALID_PAGE_ID : it->second;
+}
+
+void FreeSpaceMap::SetLastPageId(page_id_t last_page_id) {
+  if (last_page_id == last_page_id_) {
+    return;
+  }
+  last_page_id_ = last_page_id;
+  auto guard = buffer_pool_manager_->FetchPageWrite(pages_[0]);
+  guard.AsMut<FreeSpaceMapPage>()->SetLastPageId(last_page_id);
+}
+
+void FreeSpaceMap::Destroy() {
+  for (page_id_t page_id : pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  Reset();
+}
+
+void FreeSpaceMap::Reset() {
+  pages_.clear();
+  slots_.clear();
+  by_space_.clear();
+  free_slots_.clear();
+  unchecked_.clear();
+  num_slots_ = 0;
+  last_page_id_ = INVALID_PAGE_ID;
+}
+
+/**
+ * 槽位所在的页超出链表时，新分配一页接在链表末尾
+ */
+void FreeSpaceMap::WriteSlot(uint32_t index, page_id_t page_id, uint8_t bucket) {
+  uint32_t position = index / FreeSpaceMapPage::CAPACITY;
+  while (position >= pages_.size()) {
+    page_id_t new_page_id;
+    auto new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id);
+    ASSERT(new_guard.IsValid(), "Failed to allocate a free space map page.");
+    new_guard.AsMut<FreeSpaceMapPage>()->Init();
+    auto prev_guard = buffer_pool_manager_->FetchPageWrite(pages_.back());
+    prev_guard.AsMut<FreeSpaceMapPage>()->SetNextPageId(new_page_id);
+    pages_.push_back(new_page_id);
+  }
+  auto guard = buffer_pool_manager_->FetchPageWrite(pages_[position]);
+  guard.AsMut<FreeSpaceMapPage>()->SetSlot(index % FreeSpaceMapPage::CAPACITY, page_id, bucket);
+}
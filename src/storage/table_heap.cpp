@@ -1,72 +1,134 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
+
 /**
- * Done
- * 1. 从第一页开始插入
- * 2. 如果插入失败，新建一页
+ * 1. 从空闲空间表中找一个放得下元组的页插入，空闲空间表记录的空间不足时更正后重找
+ *    从磁盘读入而未确认过的页先检查是否仍属于本堆表，不属于的从空闲空间表中删去后重找
+ * 2. 没有这样的页时，在最后一页之后新建一页插入
  * 3. 如果新建失败，返回 false
- * 4. 否则，插入成功，返回 true
  */
 bool TableHeap::InsertTuple(Row &row, Txn *txn) {
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(GetFirstPageId()));
-  bool is_not_valid = buffer_pool_manager_->IsPageFree(GetFirstPageId());
-  if(is_not_valid) {//当判断出首页不可用，则新建首页
-    page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
-  }
-  if(page == nullptr)//如果创建失败，返回false
-  {
-    buffer_pool_manager_->UnpinPage(first_page_id_, false);
+  uint32_t size = row.GetSerializedSize(schema_);
+  if (size > TablePage::SIZE_MAX_ROW) {
     return false;
   }
-  page_num = 1;
-  page_id_t page_id = GetFirstPageId();//获取首页id
-  while(1)
-  {
-    //尝试将row插入当前页，若成功，则返回true
-    if(page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_))
-    {
-      return buffer_pool_manager_->UnpinPage(page_id, true);
+  page_id_t page_id;
+  while ((page_id = free_space_map_.FindPage(size + TablePage::SIZE_TUPLE)) != INVALID_PAGE_ID) {
+    if (free_space_map_.IsUnchecked(page_id) && !IsHeapPage(page_id)) {
+      free_space_map_.Remove(page_id);
+      continue;
     }
-    //若失败，则获取下一页
-    auto next_page_id = page->GetNextPageId();
-    if(next_page_id == INVALID_PAGE_ID)//若下一页无效，则新建下一页
-    {
-      auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
-      if(new_page == nullptr || next_page_id == INVALID_PAGE_ID)//若新建失败，则返回false
-      {
-        buffer_pool_manager_->UnpinPage(page_id, false);
-        return false;
-      }
-      else{//若创建成功
-        page_num++;
-        new_page->Init(next_page_id, page_id, log_manager_, txn);//并初始化新页
-        page->SetNextPageId(next_page_id);//将其设置为上一页的下一页
-        buffer_pool_manager_->UnpinPage(page_id, false);//解引用
-        page = new_page;//更新page
-        page_id = next_page_id;//更新page_id
-      }
+    auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    if (!guard.IsValid()) {
+      free_space_map_.Remove(page_id);
+      continue;
     }
-    else{//若下一页有效，获得下一页并作为当前页，继续循环
-      buffer_pool_manager_->UnpinPage(page_id, false);
-      page_id = next_page_id;
-      page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    auto page = reinterpret_cast<TablePage *>(guard.GetPageMut());
+    bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    free_space_map_.Update(page_id, page->GetFreeSpaceRemaining());
+    if (inserted) {
+      return true;
     }
   }
-  return false;
+  auto guard = AppendPage(txn);
+  if (!guard.IsValid()) {
+    return false;
+  }
+  auto page = reinterpret_cast<TablePage *>(guard.GetPageMut());
+  bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  free_space_map_.Update(guard.PageId(), page->GetFreeSpaceRemaining());
+  return inserted;
+}
+
+BasicPageGuard TableHeap::AppendPage(Txn *txn) {
+  page_id_t last_page_id = free_space_map_.GetLastPageId();
+  page_id_t new_page_id;
+  auto new_guard = buffer_pool_manager_->NewPageGuarded(new_page_id, &segment_);
+  if (!new_guard.IsValid()) {
+    return new_guard;
+  }
+  reinterpret_cast<TablePage *>(new_guard.GetPageMut())->Init(new_page_id, last_page_id, log_manager_, txn);
+  auto last_guard = buffer_pool_manager_->FetchPageBasic(last_page_id);
+  reinterpret_cast<TablePage *>(last_guard.GetPageMut())->SetNextPageId(new_page_id);
+  free_space_map_.SetLastPageId(new_page_id);
+  return new_guard;
+}
+
+/**
+ * 首页的 PrevPageId 指向空闲空间表。打开时只读空闲空间表，不遍历页链表，代价与表的大小无关
+ * 1. 崩溃后空闲空间表可能落后于页链表：已释放的页在读入时丢弃，其余的页由 InsertTuple 第一次选中时确认
+ * 2. 记录的最后一页之后可能还接着崩溃前追加而未记入的页，从它沿 NextPageId 走到真正的最后一页
+ * 3. 没有空闲空间表（旧的数据库文件）时新建一个，它和记录的最后一页已不在链表上时一样，从首页沿链表走一遍
+ */
+void TableHeap::LoadFreeSpaceMap() {
+  auto first_guard = buffer_pool_manager_->FetchPageBasic(first_page_id_);
+  ASSERT(first_guard.IsValid(), "ERROR: cannot fetch the first page of table heap, please check");
+  page_id_t fsm_page_id = reinterpret_cast<const TablePage *>(first_guard.GetPage())->GetPrevPageId();
+  page_id_t last_page_id = INVALID_PAGE_ID;
+  if (free_space_map_.Load(fsm_page_id, [this](page_id_t page_id) { return IsAllocated(page_id); })) {
+    last_page_id = free_space_map_.GetLastPageId();
+  } else {
+    fsm_page_id = free_space_map_.Create();
+    ASSERT(fsm_page_id != INVALID_PAGE_ID, "ERROR: cannot create the free space map of table heap, please check");
+    reinterpret_cast<TablePage *>(first_guard.GetPageMut())->SetPrevPageId(fsm_page_id);
+  }
+  first_guard.Drop();
+  page_id_t page_id = last_page_id != INVALID_PAGE_ID && IsHeapPage(last_page_id) ? last_page_id : first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    ASSERT(guard.IsValid(), "ERROR: cannot fetch a page of table heap, please check");
+    auto page = reinterpret_cast<const TablePage *>(guard.GetPage());
+    free_space_map_.Update(page_id, page->GetFreeSpaceRemaining());
+    last_page_id = page_id;
+    page_id = page->GetNextPageId();
+  }
+  free_space_map_.SetLastPageId(last_page_id);
+}
+
+bool TableHeap::IsAllocated(page_id_t page_id) {
+  return page_id >= 0 && page_id < MAX_VALID_PAGE_ID && !buffer_pool_manager_->IsPageFree(page_id);
+}
+
+/**
+ * 页可能已被释放并交给了另一个表或索引：表页记录着自己的页号，链表上的页是其前一页的后继
+ */
+bool TableHeap::IsHeapPage(page_id_t page_id) {
+  if (page_id == first_page_id_) {
+    return true;
+  }
+  if (!IsAllocated(page_id)) {
+    return false;
+  }
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+  if (!guard.IsValid()) {
+    return false;
+  }
+  auto page = reinterpret_cast<const TablePage *>(guard.GetPage());
+  page_id_t prev_page_id = page->GetPrevPageId();
+  if (page->GetTablePageId() != page_id || !IsAllocated(prev_page_id)) {
+    return false;
+  }
+  guard.Drop();
+  auto prev_guard = buffer_pool_manager_->FetchPageBasic(prev_page_id);
+  if (!prev_guard.IsValid()) {
+    return false;
+  }
+  auto prev_page = reinterpret_cast<const TablePage *>(prev_guard.GetPage());
+  return prev_page->GetTablePageId() == prev_page_id && prev_page->GetNextPageId() == page_id;
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the recovery.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     return false;
   }
   // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  if (reinterpret_cast<TablePage *>(guard.GetPageMut())->MarkDelete(rid, txn, lock_manager_, log_manager_)) {
+    num_dead_tuples_++;
+  }
   return true;
 }
 
@@ -75,26 +137,26 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
  */
 bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
   auto page_id = rid.GetPageId();
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-  if(page == nullptr)
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+  if(!guard.IsValid())
   {
-    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
     return false;
   }
+  auto page = reinterpret_cast<TablePage *>(guard.GetPageMut());
   Row old_row;//定义一个row
   old_row.SetRowId(rid);//设置rowid
   //这里将tablepage的updatetuple函数进行了修改，返回值分为1,-1，-2，-3
   int res = page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_);
   if(res == 1)//返回1说明一切正常
   {
-    buffer_pool_manager_->UnpinPage(page_id, true);
+    free_space_map_.Update(page_id, page->GetFreeSpaceRemaining());
     return true;
   }
   else if(res == -3)//返回-3，则表明剩余的空闲空间加上旧元组的大小小于新元组的序列化大小
   {
+    guard.Drop();
     ApplyDelete(rid, txn);//可先删除旧元组
     InsertTuple(row, txn);//再将新元组进行插入
-    buffer_pool_manager_->UnpinPage(page_id, true);//脏页
     //Log(INFO) << "Table_Heap::UpdateTuple() succeed: " << "page_id: " << page_id;
     return true;
   }
@@ -111,27 +173,24 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
   // Step1: Find the page which contains the tuple.
   // Step2: Delete the tuple from the page.
   auto page_id = rid.GetPageId();
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-  if(page == nullptr)//如果此页不存在，则什么都不做
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+  if(!guard.IsValid())//如果此页不存在，则什么都不做
   {
-    buffer_pool_manager_->UnpinPage(first_page_id_, false);
     return;
   }
   else {//否则，删除该行，并标记位脏页
+    auto page = reinterpret_cast<TablePage *>(guard.GetPageMut());
     page->ApplyDelete(rid, txn, log_manager_);
-    buffer_pool_manager_->UnpinPage(page_id, true);
+    free_space_map_.Update(page_id, page->GetFreeSpaceRemaining());
   }
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(guard.IsValid());
   // Rollback to delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  reinterpret_cast<TablePage *>(guard.GetPageMut())->RollbackDelete(rid, txn, log_manager_);
 }
 
 /**
@@ -144,34 +203,45 @@ void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
 bool TableHeap::GetTuple(Row *row, Txn *txn) {
   RowId rowid = row->GetRowId();
   auto page_id = rowid.GetPageId();//找到row所在的page
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-  if(page == nullptr){
-    buffer_pool_manager_->UnpinPage(page_id, false);
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+  if(!guard.IsValid()){
     return false;
   }
-  if(page->GetTuple(row, schema_, txn, lock_manager_))
-  {
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    return true;
-  }
-  buffer_pool_manager_->UnpinPage(page_id, false);
-  return false;
+  return reinterpret_cast<const TablePage *>(guard.GetPage())->GetTuple(row, schema_, txn, lock_manager_);
 }
 
 /**
- * 1. 如果page_id 为 INVALID_PAGE_ID，删除第一个页
- * 2. 如果不是，fetchpage 并删除
+ * 1. 如果page_id 为 INVALID_PAGE_ID，从第一个页开始删除
+ * 2. 沿链表逐页 fetchpage 读出后继页后删除，仍被别人 pin 住而删除失败的页记入 pages_to_free_ 稍后重试
  */
-void TableHeap::DeleteTable(page_id_t page_id) {
-  if (page_id != INVALID_PAGE_ID) {
-    auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
-    if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID)
-      DeleteTable(temp_table_page->GetNextPageId());
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    buffer_pool_manager_->DeletePage(page_id);
-  } else {
-    DeleteTable(first_page_id_);
+bool TableHeap::DeleteTable(page_id_t page_id) {
+  chain_version_++;
+  if (page_id == INVALID_PAGE_ID) {
+    free_space_map_.Destroy();
+    page_id = first_page_id_;
+  }
+  while (page_id != INVALID_PAGE_ID) {
+    auto guard = buffer_pool_manager_->FetchPageBasic(page_id);  // 删除table_heap
+    if (!guard.IsValid()) {
+      break;
+    }
+    page_id_t next_page_id = reinterpret_cast<const TablePage *>(guard.GetPage())->GetNextPageId();
+    guard.Drop();
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+      pages_to_free_.push_back(page_id);
+    }
+    page_id = next_page_id;
   }
+  FreeUnlinkedPages();
+  return pages_to_free_.empty();
+}
+
+uint32_t TableHeap::FreeUnlinkedPages() {
+  auto end = std::remove_if(pages_to_free_.begin(), pages_to_free_.end(),
+                            [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+  auto num_freed = static_cast<uint32_t>(pages_to_free_.end() - end);
+  pages_to_free_.erase(end, pages_to_free_.end());
+  return num_freed;
 }
 
 /**
@@ -180,7 +250,8 @@ void TableHeap::DeleteTable(page_id_t page_id) {
  * 2. 否则，找到第一个有效的页，并返回迭代器
  *
  */
-TableIterator TableHeap::Begin(Txn *txn) {
+TableIterator TableHeap::Begin(Txn *txn, bool bulk_read) {
+  std::shared_ptr<BufferRing> ring = bulk_read ? std::make_shared<BufferRing>() : nullptr;
   page_id_t page_id = first_page_id_;//取出首页id
   RowId result_rid;
   while(1)
@@ -189,20 +260,20 @@ TableIterator TableHeap::Begin(Txn *txn) {
     {
       return End();
     }
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BasicPageGuard guard(buffer_pool_manager_, buffer_pool_manager_->FetchPage(page_id, ring.get()));
+    auto page = reinterpret_cast<const TablePage *>(guard.GetPage());
     if(page->GetFirstTupleRid(&result_rid))//获取第一个元组id
     {
-      buffer_pool_manager_->UnpinPage(page_id, false);
       break;//获取成功则退出循环
     }
-    buffer_pool_manager_->UnpinPage(page_id, false);
     page_id = page->GetNextPageId();//如果获取失败，说明该页已经无效（通过观察GetFirstTupleRid得出），则寻找下一页
   }
   if(page_id != INVALID_PAGE_ID)//获取元组成功
   {
     Row* result_row = new Row(result_rid);//用找到的元组id构造row
     GetTuple(result_row, txn);//用该row获取tuple
-    return TableIterator(this, result_rid, txn, result_row);//返回迭代器
+    result_row->SetRowId(result_rid);//元组中序列化的 rid 是插入前的，与 operator++ 一样重新设置
+    return TableIterator(this, result_rid, txn, result_row, ring);//返回迭代器
   }
   return End();
 }
@@ -214,3 +285,85 @@ TableIterator TableHeap::End() {
   RowId null;//创建的是一个无效的行ID，并不对应于堆表中的任何行
   return TableIterator(this, null, nullptr, nullptr);
 }
+
+/**
+ * 1. 压缩当前页，回收被删除元组的空间
+ * 2. 若后继页的存活元组能全部放入当前页的空闲空间，则将其逐个移入当前页，把后继页从链表中摘除并删除，重复此步
+ * 3. 否则处理后继页，直到扫描的页数达到 max_pages
+ * 首页不会被删除，它的页号记录在表的元信息中
+ * 从上一次返回的页续做时该页不再压缩，只尝试把后继页并入它，因此每次调用至少压缩一个新的页
+ * 并入后的页若仍被别人 pin 住（如扫描的预读或未释放的 guard）则无法删除，记入 pages_to_free_，由之后的调用释放
+ */
+page_id_t TableHeap::Vacuum(page_id_t start, uint32_t max_pages, const MoveCallback &on_move, VacuumStats *stats,
+                            Txn *txn) {
+  stats->pages_freed += FreeUnlinkedPages();
+  uint32_t num_scanned = 0;
+  // 已压缩过的页，轮到它时不再重复压缩，也不计入 max_pages。续做的起始页在上一次调用中已经压缩过，
+  // 否则 max_pages 为 1 时每次都只压缩起始页并原样返回它，永远无法前进
+  page_id_t compacted_page_id = start;
+  auto compact = [&](page_id_t page_id, TablePage *page) {
+    if (page_id == compacted_page_id) {
+      return;
+    }
+    uint32_t num_removed = page->Vacuum(txn, log_manager_);
+    num_scanned++;
+    stats->pages_scanned++;
+    stats->tuples_removed += num_removed;
+    num_dead_tuples_ -= std::min<uint64_t>(num_dead_tuples_, num_removed);
+    free_space_map_.Update(page_id, page->GetFreeSpaceRemaining());
+    compacted_page_id = page_id;
+  };
+  page_id_t page_id = start == INVALID_PAGE_ID ? first_page_id_ : start;
+  while (page_id != INVALID_PAGE_ID && num_scanned < max_pages) {
+    auto guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    if (!guard.IsValid()) {
+      return INVALID_PAGE_ID;
+    }
+    auto page = reinterpret_cast<TablePage *>(guard.GetPageMut());
+    compact(page_id, page);
+    page_id_t next_page_id;
+    while ((next_page_id = page->GetNextPageId()) != INVALID_PAGE_ID) {
+      if (num_scanned >= max_pages) {
+        // 当前页可能还能并入后继页，下次从当前页继续
+        return page_id;
+      }
+      auto next_guard = buffer_pool_manager_->FetchPageWrite(next_page_id);
+      if (!next_guard.IsValid()) {
+        return page_id;
+      }
+      auto next_page = reinterpret_cast<TablePage *>(next_guard.GetPageMut());
+      compact(next_page_id, next_page);
+      if (next_page->GetUsedSpace() > page->GetFreeSpaceRemaining()) {
+        break;
+      }
+      RowId rid;
+      for (bool found = next_page->GetFirstTupleRid(&rid); found; found = next_page->GetNextTupleRid(rid, &rid)) {
+        Row row(rid);
+        next_page->GetTuple(&row, schema_, txn, lock_manager_);
+        bool __attribute__((unused)) inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+        ASSERT(inserted, "The tuples of the next page must fit in the page.");
+        on_move(row, rid);
+        stats->tuples_moved++;
+      }
+      free_space_map_.Update(page_id, page->GetFreeSpaceRemaining());
+      page_id_t after_page_id = next_page->GetNextPageId();
+      page->SetNextPageId(after_page_id);
+      if (after_page_id != INVALID_PAGE_ID) {
+        auto after_guard = buffer_pool_manager_->FetchPageWrite(after_page_id);
+        reinterpret_cast<TablePage *>(after_guard.GetPageMut())->SetPrevPageId(page_id);
+      } else {
+        free_space_map_.SetLastPageId(page_id);
+      }
+      next_guard.Drop();
+      free_space_map_.Remove(next_page_id);
+      chain_version_++;
+      if (buffer_pool_manager_->DeletePage(next_page_id)) {
+        stats->pages_freed++;
+      } else {
+        pages_to_free_.push_back(next_page_id);
+      }
+    }
+    page_id = next_page_id;
+  }
+  return page_id;
+}
@@ -6,20 +6,26 @@
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row) {
+TableIterator::TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row, std::shared_ptr<BufferRing> ring) {
   this->table_heap_ = table_heap;
   this->rid = rid;
   this->txn = txn;
+  this->ring_ = std::move(ring);
   if (row) {
     this->row_ = new Row(*row);
   }
   else this->row_ = nullptr;
+  if (ring_ != nullptr && rid.GetPageId() != INVALID_PAGE_ID) {
+    ReadAhead(rid.GetPageId());
+  }
 }
 
 TableIterator::TableIterator(const TableIterator &other) {
   table_heap_ = other.table_heap_;
   rid = other.rid;
   txn = other.txn;
+  ring_ = other.ring_;
+  readahead_ = other.readahead_;
   if (other.row_) {
     row_ = new Row(*other.row_);
   }
@@ -54,6 +60,8 @@ TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
   table_heap_ = itr.table_heap_;
   rid = itr.rid;
   txn = itr.txn;
+  ring_ = itr.ring_;
+  readahead_ = itr.readahead_;
   return *this;
 }
 
@@ -63,7 +71,9 @@ TableIterator &TableIterator::operator++() {
   ASSERT(row_ != nullptr, "ERROR: do \"++\" operation on a null iterator is wrong");//如果row_ == nullptr，则报错
   page_id_t page_id = rid.GetPageId();
   ASSERT(page_id != INVALID_PAGE_ID, "ERROR: do \"++\" operation on end iterator is wrong");//如果page_id == INVALID，说明已经到结尾，报错
-  auto *page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page_id));
+  auto *bpm = table_heap_->buffer_pool_manager_;
+  BasicPageGuard guard(bpm, bpm->FetchPage(page_id, ring_.get()));
+  auto *page = reinterpret_cast<const TablePage *>(guard.GetPage());
   ASSERT(page_id == page->GetPageId(), "ERROR: \"page_id == page->GetPageId()\" should be true");//简单判断一下
   RowId nextid;//准备存储下一个rowid
   if (page->GetNextTupleRid(rid, &nextid)) {
@@ -72,28 +82,27 @@ TableIterator &TableIterator::operator++() {
     row_->SetRowId(rid);//将row设置成下一个row
     table_heap_->GetTuple(row_, nullptr);//获取下一个row
     row_->SetRowId(rid);
-    table_heap_->buffer_pool_manager_->UnpinPage(page_id, false);
     return *this;
   }
   //如果获取下一个row失败，则可能是当前页已经读到最后一个row，需要读取下一页
   page_id_t next_page_id = INVALID_PAGE_ID;
   while ((next_page_id = page->GetNextPageId()) != INVALID_PAGE_ID) {//持续获取有效的下一页，直到在该页可以得到元组
-    auto *next_page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(next_page_id));
-    page = next_page;
+    guard = BasicPageGuard(bpm, bpm->FetchPage(next_page_id, ring_.get()));//离开当前页前解引用
+    page = reinterpret_cast<const TablePage *>(guard.GetPage());
+    if (ring_ != nullptr) {
+      ReadAhead(next_page_id);
+    }
     if (page->GetFirstTupleRid(&nextid)) {//获取首个元组，若失败，则继续循环
       row_->GetFields().clear();
       rid = nextid;
       row_->SetRowId(rid);
       table_heap_->GetTuple(row_, nullptr);
       row_->SetRowId(rid);
-      table_heap_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
       return *this;
     }
-    table_heap_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
   }
   // ++失败
   rid.Set(INVALID_PAGE_ID, 0);//rid设置无效页
-  table_heap_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
   return *this;
 }
 
@@ -104,5 +113,33 @@ TableIterator TableIterator::operator++(int) {
   TableHeap* this_heap_next = this->table_heap_;
   RowId rid_next = this->rid;
   ++(*this);//再调用++iter重载函数
-  return TableIterator(this_heap_next, rid_next, nullptr, row_next);
+  return TableIterator(this_heap_next, rid_next, nullptr, row_next, ring_);
+}
+
+void TableIterator::ReadAhead(page_id_t page_id) {
+  auto *bpm = table_heap_->buffer_pool_manager_;
+  // 丢弃已经到达的页
+  while (!readahead_.empty()) {
+    page_id_t front = readahead_.front();
+    readahead_.pop_front();
+    if (front == page_id) {
+      break;
+    }
+  }
+  page_id_t tail_id = readahead_.empty() ? page_id : readahead_.back();
+  while (readahead_.size() < static_cast<size_t>(READAHEAD_PAGES)) {
+    // 只沿着已经读入内存的页查找下一页，尚未读入的页留到下次再继续
+    auto *tail = reinterpret_cast<TablePage *>(bpm->TryFetchPage(tail_id));
+    if (tail == nullptr) {
+      break;
+    }
+    page_id_t next_page_id = tail->GetNextPageId();
+    bpm->UnpinPage(tail_id, false);
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    bpm->PrefetchPage(next_page_id, ring_);
+    readahead_.push_back(next_page_id);
+    tail_id = next_page_id;
+  }
 }
@@ -1,8 +1,12 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <chrono>
 #include <cstdio>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -34,7 +38,7 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   // Insert terminal characters both in the middle and at end
   random_binary_data[PAGE_SIZE / 2] = '\0';
-  random_binary_data[PAGE_SIZE - 1] = '\0';
+  random_binary_data[PAGE_USABLE_SIZE - 1] = '\0';
 
   // Scenario: Once we have a page, we should be able to read and write content.
   std::memcpy(page0->GetData(), random_binary_data, PAGE_SIZE);
@@ -67,7 +71,7 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
   // Scenario: We should be able to fetch the data we wrote a while ago.
   page0 = bpm->FetchPage(0);
   // LOG(WARNING) << "test0" << page0->GetPageId();
-  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, PAGE_USABLE_SIZE));
   // LOG(WARNING) << "test1" << std::endl;
   EXPECT_EQ(true, bpm->UnpinPage(0, true));
 
@@ -77,4 +81,410 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+TEST(BufferPoolManagerTest, ShardedConcurrentTest) {
+  const std::string db_name = "bpm_sharded_test.db";
+  const size_t buffer_pool_size = 256;
+  const size_t num_instances = 4;
+  const int num_threads = 4;
+  const int pages_per_thread = 100;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+  ASSERT_EQ(num_instances, bpm->GetNumInstances());
+
+  // Scenario: every thread creates its own pages, stamps them and unpins them, so the shards see concurrent misses.
+  std::vector<std::vector<page_id_t>> thread_pages(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        Page *page = bpm->NewPage(page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+        thread_pages[t].push_back(page_id);
+        ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+
+  // Scenario: more pages than frames were created, every page must come back with its own content.
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      char expected[PAGE_SIZE];
+      for (auto page_id : thread_pages[t]) {
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+        EXPECT_STREQ(expected, page->GetData());
+        ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ConcurrentMissTest) {
+  const std::string db_name = "bpm_concurrent_miss_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+  const int num_threads = 8;
+  const int rounds = 400;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  // The other tests use the default LRU policy, run this one with CLOCK.
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, ReplacerType::kClock);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the pool is much smaller than the working set, threads keep missing on (often the same) pages while
+  // dirty victims are written back, every fetch must observe the page's own content.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < rounds; i++) {
+        page_id_t page_id = page_ids[(i * 7 + t) % num_pages];
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;  // all frames are pinned by other threads
+        }
+        snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+        EXPECT_STREQ(expected, page->GetData());
+        ASSERT_TRUE(bpm->UnpinPage(page_id, i % 3 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BufferRingTest) {
+  const std::string db_name = "bpm_buffer_ring_test.db";
+  const size_t buffer_pool_size = 64;
+  const int hot_pages = 16;
+  const int num_pages = 200;
+
+  for (bool use_ring : {true, false}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+      page_ids.push_back(page_id);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    // Scenario: stamp the hot pages in memory only, the stamp survives as long as the page stays resident.
+    for (int i = 0; i < hot_pages; i++) {
+      Page *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "hot-%d", page_ids[i]);
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+    // Scenario: scan all the other pages, through a ring or not.
+    BufferRing ring(8);
+    char expected[PAGE_SIZE];
+    for (int i = hot_pages; i < num_pages; i++) {
+      Page *page = bpm->FetchPage(page_ids[i], use_ring ? &ring : nullptr);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page-%d", page_ids[i]);
+      EXPECT_STREQ(expected, page->GetData());
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+    int resident = 0;
+    for (int i = 0; i < hot_pages; i++) {
+      Page *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "hot-%d", page_ids[i]);
+      resident += strcmp(expected, page->GetData()) == 0 ? 1 : 0;
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+    if (use_ring) {
+      EXPECT_EQ(hot_pages, resident);
+    } else {
+      EXPECT_EQ(0, resident);
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+    delete bpm;
+    disk_manager->Close();
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const std::string db_name = "bpm_background_writer_test.db";
+  const size_t buffer_pool_size = 64;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    page_ids.push_back(page_id);
+  }
+  // Scenario: pinned pages are never written back by the background writer.
+  EXPECT_EQ(0, bpm->WriteBackDirtyPages(16, 50));
+  for (auto page_id : page_ids) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the budget bounds a round, and the writer stops once enough frames are clean.
+  EXPECT_EQ(16, bpm->WriteBackDirtyPages(16, 50));
+  EXPECT_EQ(16, bpm->WriteBackDirtyPages(64, 50));
+  EXPECT_EQ(0, bpm->WriteBackDirtyPages(64, 50));
+
+  // Scenario: the background thread cleans the rest of the pool.
+  bpm->StartBackgroundWriter(100, 8, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(0, bpm->WriteBackDirtyPages(64, 100));
+
+  // Every page reached the disk without being flushed or evicted.
+  char expected[PAGE_SIZE];
+  char data[PAGE_SIZE];
+  for (auto page_id : page_ids) {
+    disk_manager->ReadPage(page_id, data);
+    snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+    EXPECT_STREQ(expected, data);
+  }
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "bpm_prefetch_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 128;
+  const int prefetch_pages = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Scenario: the first pages were evicted, they are not available without reading them.
+  for (int i = 0; i < prefetch_pages; i++) {
+    EXPECT_EQ(nullptr, bpm->TryFetchPage(page_ids[i]));
+  }
+  // Scenario: prefetched pages show up in the pool, unpinned, without the caller waiting for them.
+  for (int i = 0; i < prefetch_pages; i++) {
+    bpm->PrefetchPage(page_ids[i]);
+  }
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < prefetch_pages; i++) {
+    Page *page = nullptr;
+    for (int retry = 0; retry < 1000 && page == nullptr; retry++) {
+      page = bpm->TryFetchPage(page_ids[i]);
+      if (page == nullptr) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", page_ids[i]);
+    EXPECT_STREQ(expected, page->GetData());
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_test.db";
+  const size_t buffer_pool_size = 10;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Scenario: every page is resident, fetches are hits.
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size, stats.Get(BufferPoolStats::kNewPages));
+  EXPECT_EQ(buffer_pool_size, stats.Get(BufferPoolStats::kFetches));
+  EXPECT_EQ(buffer_pool_size, stats.Get(BufferPoolStats::kHits));
+  EXPECT_EQ(0, stats.Get(BufferPoolStats::kMisses));
+  EXPECT_EQ(0, stats.Get(BufferPoolStats::kEvictions));
+  EXPECT_DOUBLE_EQ(1.0, stats.HitRatio());
+
+  // Scenario: new pages evict the dirty pages, reading one back is a miss.
+  for (int i = 0; i < 5; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[0], true));
+  ASSERT_TRUE(bpm->FlushPage(page_ids[0]));
+  ASSERT_TRUE(bpm->FlushPage(page_ids[0]));
+  ASSERT_TRUE(bpm->DeletePage(page_ids[0]));
+  stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size + 1, stats.Get(BufferPoolStats::kFetches));
+  EXPECT_EQ(1, stats.Get(BufferPoolStats::kMisses));
+  EXPECT_EQ(6, stats.Get(BufferPoolStats::kEvictions));
+  EXPECT_EQ(6, stats.Get(BufferPoolStats::kDirtyEvictions));
+  EXPECT_EQ(1, stats.Get(BufferPoolStats::kFlushes));
+  EXPECT_EQ(1, stats.Get(BufferPoolStats::kDeletedPages));
+  EXPECT_EQ(1, stats.Get(BufferPoolStats::kDiskReads));
+  EXPECT_EQ(7, stats.Get(BufferPoolStats::kDiskWrites));
+  EXPECT_GT(stats.Get(BufferPoolStats::kWriteTimeNs), 0);
+  EXPECT_EQ(stats.Get(BufferPoolStats::kFetches), bpm->GetInstanceStats(0).Get(BufferPoolStats::kFetches));
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WarmRestartTest) {
+  const std::string db_name = "bpm_test.db";
+  const std::string dump_name = "bpm_test.db.bpdump";
+  const size_t buffer_pool_size = 10;
+
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Pages 12..15 are the most recently accessed ones.
+  for (size_t i = 12; i < 16; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  ASSERT_TRUE(bpm->DumpResidentPages(dump_name));
+  delete bpm;
+
+  // Scenario: a missing dump loads nothing.
+  bpm = new BufferPoolManager(4, disk_manager, 1);
+  EXPECT_EQ(0, bpm->LoadResidentPages(dump_name + ".missing"));
+
+  // Scenario: a smaller pool keeps the most recent pages of the dump, pages freed since the dump are skipped.
+  ASSERT_TRUE(bpm->DeletePage(page_ids[13]));
+  EXPECT_EQ(4, bpm->LoadResidentPages(dump_name));
+  for (int i = 0; i < 500 && bpm->GetStats().Get(BufferPoolStats::kPrefetches) < 3; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopWarmup();
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(3, stats.Get(BufferPoolStats::kPrefetches));
+  EXPECT_EQ(0, stats.Get(BufferPoolStats::kEvictions));
+  for (size_t i : {12, 14, 15}) {
+    Page *page = bpm->TryFetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(nullptr, bpm->TryFetchPage(page_ids[13]));
+  EXPECT_EQ(nullptr, bpm->TryFetchPage(page_ids[0]));
+
+  // Scenario: a dump whose page count exceeds its size is ignored instead of being allocated.
+  {
+    std::fstream dump(dump_name, std::ios::binary | std::ios::in | std::ios::out);
+    uint32_t num_pages = UINT32_MAX;
+    dump.seekp(sizeof(uint32_t));
+    dump.write(reinterpret_cast<const char *>(&num_pages), sizeof(num_pages));
+  }
+  EXPECT_EQ(0, bpm->LoadResidentPages(dump_name));
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, DirectIoTest) {
+  const std::string db_name = "bpm_test.db";
+  const size_t buffer_pool_size = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name, DurabilityMode::kPeriodic, true);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  // Every frame is aligned, so that the pool reads and writes it with O_DIRECT without a copy.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 4 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
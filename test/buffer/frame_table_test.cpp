@@ -0,0 +1,76 @@
+#include "buffer/frame_table.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+TEST(FrameTableTest, LayoutTest) {
+  // Scenario: a slab of at least a huge page is aligned to it, the data of frame i is at i * PAGE_SIZE.
+  const size_t num_frames = FrameTable::HUGE_PAGE_SIZE / PAGE_SIZE + 3;
+  FrameTable table(num_frames);
+  EXPECT_EQ(num_frames, table.GetNumFrames());
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(table.GetData()) % FrameTable::HUGE_PAGE_SIZE);
+  LOG(INFO) << "huge pages: " << (table.IsHugeTlb() ? "reserved" : "transparent") << ", sizeof(Page) "
+            << sizeof(Page) << " bytes" << std::endl;
+  for (size_t i = 0; i < num_frames; i++) {
+    Page &page = table.GetPages()[i];
+    ASSERT_EQ(table.GetData() + i * PAGE_SIZE, page.GetData());
+    ASSERT_EQ(INVALID_PAGE_ID, page.GetPageId());
+    ASSERT_EQ(0, page.GetPinCount());
+    ASSERT_EQ(0, page.GetData()[0]);
+    ASSERT_EQ(0, page.GetData()[PAGE_SIZE - 1]);
+  }
+  // The metadata of a frame fits in a cache line, a sweep reads one line per frame at most.
+  EXPECT_LE(sizeof(Page), 64);
+
+  // Scenario: a small slab is still PAGE_SIZE aligned, as O_DIRECT needs.
+  FrameTable small_table(3);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(small_table.GetData()) % PAGE_SIZE);
+  small_table.GetPages()[2].GetData()[PAGE_SIZE - 1] = 1;
+}
+
+namespace {
+/** The frame layout before FrameTable, the data of the page embedded in front of its metadata. */
+struct EmbeddedFrame {
+  char data[PAGE_SIZE];
+  page_id_t page_id;
+  int pin_count;
+  bool is_dirty;
+};
+}  // namespace
+
+/**
+ * Count the pinned frames of a pool of 64 MiB, as CheckAllUnpinned does, over the dense metadata of a FrameTable and
+ * over the embedded layout.
+ */
+TEST(FrameTableTest, MetadataSweepBenchmarkTest) {
+  const size_t num_frames = 16384;
+  const int num_sweeps = 20;
+  FrameTable table(num_frames);
+  std::unique_ptr<EmbeddedFrame[]> embedded(new EmbeddedFrame[num_frames]());
+  for (size_t i = 0; i < num_frames; i++) {
+    // Fault the data in, as a full pool would have it.
+    table.GetPages()[i].GetData()[0] = 1;
+    embedded[i].data[0] = 1;
+  }
+  auto sweep = [num_sweeps](auto pin_count_of) {
+    auto start = std::chrono::steady_clock::now();
+    size_t pinned = 0;
+    for (int s = 0; s < num_sweeps; s++) {
+      for (size_t i = 0; i < num_frames; i++) {
+        pinned += pin_count_of(i) != 0;
+      }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(0, pinned);
+    return num_sweeps * num_frames / seconds / 1e6;
+  };
+  double dense = sweep([&table](size_t i) { return table.GetPages()[i].GetPinCount(); });
+  double strided = sweep([&embedded](size_t i) { return reinterpret_cast<volatile int &>(embedded[i].pin_count); });
+  LOG(INFO) << "metadata sweep: FrameTable " << dense << " Mframes/s, embedded data " << strided << " Mframes/s"
+            << std::endl;
+}
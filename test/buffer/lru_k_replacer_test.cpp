@@ -0,0 +1,163 @@
+#include "buffer/lru_k_replacer.h"
+
+#include <list>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 1);
+
+  // Scenario: add six frames, frame 1 is referenced twice.
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Pin(i);
+  }
+  lru_k_replacer.Pin(1);
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single reference go first, in the order of their first access.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Scenario: 4 is referenced again, 5 and 6 now have an infinite K-distance and go before 1 and 4.
+  lru_k_replacer.Pin(4);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  lru_k_replacer.Unpin(4);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  // 1 was referenced twice before 4 was, its second most recent reference is the oldest.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 4);
+
+  // Scenario: frame 0 is fetched repeatedly in a burst, frame 1 twice far apart.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  for (int i = 0; i < 3; i++) {
+    lru_k_replacer.Pin(0);
+    lru_k_replacer.Unpin(0);
+  }
+  for (int i = 0; i < 4; i++) {
+    lru_k_replacer.Pin(2);
+    lru_k_replacer.Unpin(2);
+    lru_k_replacer.Pin(2);
+    lru_k_replacer.Pin(3);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+
+  // The burst counts as a single reference, so frame 0 is evicted before frame 1.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+}
+
+namespace {
+/** A single-shard buffer pool reduced to its page table, used to replay page reference traces. */
+class CacheSimulator {
+ public:
+  CacheSimulator(Replacer *replacer, size_t pool_size) : replacer_(replacer) {
+    for (size_t i = 0; i < pool_size; i++) {
+      free_list_.push_back(i);
+    }
+  }
+
+  /** Fetch and unpin the page, @return true on a buffer hit */
+  bool Access(page_id_t page_id) {
+    bool hit = true;
+    auto it = page_table_.find(page_id);
+    frame_id_t frame_id;
+    if (it != page_table_.end()) {
+      frame_id = it->second;
+    } else {
+      hit = false;
+      if (!free_list_.empty()) {
+        frame_id = free_list_.front();
+        free_list_.pop_front();
+      } else {
+        EXPECT_TRUE(replacer_->Victim(&frame_id));
+        page_table_.erase(frame_pages_[frame_id]);
+      }
+      page_table_[page_id] = frame_id;
+      frame_pages_[frame_id] = page_id;
+    }
+    replacer_->Pin(frame_id);
+    replacer_->Unpin(frame_id);
+    return hit;
+  }
+
+ private:
+  Replacer *replacer_;
+  list<frame_id_t> free_list_;
+  unordered_map<page_id_t, frame_id_t> page_table_;
+  unordered_map<frame_id_t, page_id_t> frame_pages_;
+};
+
+/**
+ * Replay point lookups interleaved with a full table scan, as if a lookup thread and a scan thread shared the pool.
+ * A lookup touches 3 pages of a hot set smaller than the pool, the scan reads every table page once, fetching it
+ * twice per tuple like TableIterator does.
+ * @return the hit rate of the point lookups while the scan is running
+ */
+double RunLookupWithScan(Replacer *replacer) {
+  const size_t pool_size = 256;
+  const int hot_pages = 200;
+  const int table_pages = 8192;
+  const int tuples_per_page = 4;
+  const page_id_t first_table_page = 10000;
+  CacheSimulator cache(replacer, pool_size);
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, hot_pages - 1);
+  // Warm up with lookups only.
+  for (int i = 0; i < 20000; i++) {
+    cache.Access(hot_dist(rng));
+  }
+  size_t lookups = 0, hits = 0;
+  for (int page = 0; page < table_pages; page++) {
+    for (int tuple = 0; tuple < tuples_per_page; tuple++) {
+      cache.Access(first_table_page + page);
+      cache.Access(first_table_page + page);
+      if (tuple % 2 == 0) {
+        for (int level = 0; level < 3; level++) {
+          lookups++;
+          hits += cache.Access(hot_dist(rng)) ? 1 : 0;
+        }
+      }
+    }
+  }
+  return static_cast<double>(hits) / lookups;
+}
+}  // namespace
+
+TEST(LRUKReplacerTest, ScanResistanceBenchmarkTest) {
+  const size_t pool_size = 256;
+  std::unique_ptr<Replacer> lru(Replacer::Create(ReplacerType::kLRU, pool_size));
+  std::unique_ptr<Replacer> clock(Replacer::Create(ReplacerType::kClock, pool_size));
+  std::unique_ptr<Replacer> lru_k(Replacer::Create(ReplacerType::kLRUK, pool_size));
+  double lru_hit_rate = RunLookupWithScan(lru.get());
+  double clock_hit_rate = RunLookupWithScan(clock.get());
+  double lru_k_hit_rate = RunLookupWithScan(lru_k.get());
+  LOG(INFO) << "point lookup hit rate during a full scan: LRU " << lru_hit_rate << ", CLOCK " << clock_hit_rate
+            << ", LRU-K " << lru_k_hit_rate << std::endl;
+  EXPECT_GT(lru_k_hit_rate, 0.95);
+  EXPECT_GT(lru_k_hit_rate, lru_hit_rate);
+}
@@ -1,5 +1,12 @@
 #include "buffer/lru_replacer.h"
 
+#include <chrono>
+#include <list>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "glog/logging.h"
 #include "gtest/gtest.h"
 
 TEST(LRUReplacerTest, SampleTest) {
@@ -40,4 +47,96 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(6, value);
   lru_replacer.Victim(&value);
   EXPECT_EQ(4, value);
-}
\ No newline at end of file
+
+  // Scenario: removing a frame which is not in the replacer has no effect.
+  lru_replacer.Unpin(2);
+  lru_replacer.Remove(4);
+  lru_replacer.Remove(4);
+  EXPECT_EQ(1, lru_replacer.Size());
+  lru_replacer.Remove(2);
+  EXPECT_EQ(0, lru_replacer.Size());
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+namespace {
+/** The list based replacer LRUReplacer used to be, kept as the baseline of the benchmark below. */
+class ListLRUReplacer {
+ public:
+  bool Victim(frame_id_t *frame_id) {
+    if (lru_list_.empty()) {
+      return false;
+    }
+    *frame_id = lru_list_.back();
+    lru_list_.pop_back();
+    frame_set_.erase(*frame_id);
+    return true;
+  }
+
+  void Pin(frame_id_t frame_id) {
+    auto it = frame_set_.find(frame_id);
+    if (it != frame_set_.end()) {
+      lru_list_.remove(frame_id);
+      frame_set_.erase(it);
+    }
+  }
+
+  void Unpin(frame_id_t frame_id) {
+    if (frame_set_.find(frame_id) == frame_set_.end()) {
+      lru_list_.push_front(frame_id);
+      frame_set_.insert(frame_id);
+    }
+  }
+
+ private:
+  std::list<frame_id_t> lru_list_;
+  std::unordered_set<frame_id_t> frame_set_;
+};
+
+/** Pin and unpin random frames of a full replacer, like buffer hits do, and evict from time to time. */
+template <typename ReplacerType>
+double RunHitWorkload(ReplacerType &replacer, const std::vector<frame_id_t> &accesses) {
+  auto start = std::chrono::steady_clock::now();
+  frame_id_t victim;
+  for (size_t i = 0; i < accesses.size(); i++) {
+    replacer.Pin(accesses[i]);
+    replacer.Unpin(accesses[i]);
+    if (i % 64 == 0 && replacer.Victim(&victim)) {
+      replacer.Unpin(victim);
+    }
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace
+
+TEST(LRUReplacerTest, BenchmarkTest) {
+  const size_t num_frames = 20480;
+  const size_t num_accesses = 5000;
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<frame_id_t> dist(0, num_frames - 1);
+  std::vector<frame_id_t> accesses(num_accesses);
+  for (auto &frame_id : accesses) {
+    frame_id = dist(rng);
+  }
+
+  LRUReplacer lru_replacer(num_frames);
+  ListLRUReplacer list_replacer;
+  for (size_t i = 0; i < num_frames; i++) {
+    lru_replacer.Unpin(i);
+    list_replacer.Unpin(i);
+  }
+  double lru_ms = RunHitWorkload(lru_replacer, accesses);
+  double list_ms = RunHitWorkload(list_replacer, accesses);
+  LOG(INFO) << num_accesses << " hits on " << num_frames << " frames: intrusive list " << lru_ms
+            << " ms, std::list " << list_ms << " ms" << std::endl;
+  EXPECT_EQ(num_frames, lru_replacer.Size());
+  EXPECT_LT(lru_ms, list_ms);
+
+  // Scenario: both replacers must agree on the eviction order.
+  frame_id_t lhs, rhs;
+  for (size_t i = 0; i < num_frames; i++) {
+    ASSERT_TRUE(lru_replacer.Victim(&lhs));
+    ASSERT_TRUE(list_replacer.Victim(&rhs));
+    ASSERT_EQ(rhs, lhs);
+  }
+  EXPECT_FALSE(lru_replacer.Victim(&lhs));
+}
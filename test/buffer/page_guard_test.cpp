@@ -0,0 +1,225 @@
+#include "buffer/page_guard.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "index/b_plus_tree_index.h"
+
+TEST(PageGuardTest, BasicGuardTest) {
+  const std::string db_name = "page_guard_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+
+  page_id_t page_id;
+  const Page *page;
+  {
+    auto guard = bpm->NewPageGuarded(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    page = guard.GetPage();
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, page->GetPinCount());
+
+    // Moving transfers the pin, the source no longer owns it.
+    BasicPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+    snprintf(moved.GetDataMut(), PAGE_SIZE, "Hello");
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+  EXPECT_TRUE(bpm->FlushPage(page_id));
+
+  // Reading leaves the page clean, move assignment unpins the page held before.
+  page_id_t other_page_id;
+  auto other = bpm->NewPageGuarded(other_page_id);
+  const Page *other_page = other.GetPage();
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    EXPECT_EQ(0, strcmp(guard.GetData(), "Hello"));
+    EXPECT_EQ(1, page->GetPinCount());
+    guard = std::move(other);
+    EXPECT_EQ(0, page->GetPinCount());
+    EXPECT_EQ(1, other_page->GetPinCount());
+  }
+  EXPECT_EQ(0, other_page->GetPinCount());
+  EXPECT_FALSE(page->IsDirty());
+
+  // Mutable access through the Page object marks the page dirty.
+  bpm->FetchPageBasic(page_id).GetPageMut();
+  EXPECT_TRUE(page->IsDirty());
+
+  // A failed fetch yields an invalid guard.
+  EXPECT_FALSE(bpm->FetchPageBasic(INVALID_PAGE_ID).IsValid());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(PageGuardTest, ReadWriteGuardTest) {
+  const std::string db_name = "page_guard_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+
+  page_id_t page_id;
+  bpm->NewPageGuarded(page_id).Drop();
+  {
+    // Read latches are shared.
+    auto reader1 = bpm->FetchPageRead(page_id);
+    auto reader2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, reader1.GetPage()->GetPinCount());
+  }
+
+  auto writer = bpm->FetchPageBasic(page_id).UpgradeWrite();
+  ASSERT_TRUE(writer.IsValid());
+  std::atomic<bool> read{false};
+  std::thread reader([&] {
+    auto guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(0, strcmp(guard.GetData(), "written"));
+    read = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(read);
+  snprintf(writer.GetDataMut(), PAGE_SIZE, "written");
+  writer.Drop();
+  reader.join();
+  EXPECT_TRUE(read);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(PageGuardTest, OptimisticReadTest) {
+  const std::string db_name = "page_guard_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+
+  page_id_t page_id;
+  bpm->NewPageGuarded(page_id).Drop();
+  auto guard = bpm->FetchPageBasic(page_id);
+  uint64_t version;
+  ASSERT_TRUE(guard.GetPage()->TryOptimisticRead(&version));
+
+  // A write latch taken in between invalidates the read, a held one makes it fail upfront.
+  auto writer = bpm->FetchPageWrite(page_id);
+  uint64_t ignored;
+  EXPECT_FALSE(writer.GetPage()->TryOptimisticRead(&ignored));
+  writer.Drop();
+  EXPECT_FALSE(guard.GetPage()->ValidateRead(version));
+  ASSERT_TRUE(guard.GetPage()->TryOptimisticRead(&version));
+  EXPECT_TRUE(guard.GetPage()->ValidateRead(version));
+
+  // Writers fill the page with one byte value, a validated read never sees two.
+  std::atomic<bool> stop{false};
+  std::thread writer_thread([&] {
+    for (char c = 0; !stop; c = static_cast<char>((c + 1) % 100)) {
+      auto write_guard = bpm->FetchPageWrite(page_id);
+      memset(write_guard.GetDataMut(), c, PAGE_SIZE);
+    }
+  });
+  int num_optimistic = 0;
+  for (int i = 0; i < 2000; i++) {
+    bool consistent = false;
+    if (guard.ReadOptimistic([&consistent](const char *data) {
+          consistent = std::all_of(data, data + PAGE_SIZE, [data](char c) { return c == data[0]; });
+        })) {
+      num_optimistic++;
+    }
+    ASSERT_TRUE(consistent);
+  }
+  stop = true;
+  writer_thread.join();
+  LOG(INFO) << num_optimistic << " of 2000 reads validated optimistically";
+  guard.Drop();
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/**
+ * Every storage structure built on the buffer pool must give back all its pins once an operation returns.
+ */
+TEST(PageGuardTest, NoPinLeakTest) {
+  const std::string db_name = "page_guard_leak_test.db";
+  const int row_nums = 2000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::vector<std::string> index_keys{"id"};
+  auto key_of = [](int i) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    return Row(fields);
+  };
+
+  auto *db_01 = new DBStorageEngine(db_name, true);
+  TableInfo *table_info = nullptr;
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db_01->catalog_mgr_->CreateTable("t", schema.get(), nullptr, table_info));
+  ASSERT_EQ(DB_SUCCESS, db_01->catalog_mgr_->CreateIndex("t", "t_id", index_keys, nullptr, index_info, "bptree"));
+  ASSERT_TRUE(db_01->bpm_->CheckAllUnpinned());
+
+  auto *table_heap = table_info->GetTableHeap();
+  auto *index = index_info->GetIndex();
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(key_of(i), row.GetRowId(), nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  ASSERT_TRUE(db_01->bpm_->CheckAllUnpinned());
+
+  for (int i = 0; i < row_nums; i += 2) {
+    ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+    table_heap->ApplyDelete(rids[i], nullptr);
+    ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(key_of(i), rids[i], nullptr));
+  }
+  ASSERT_TRUE(db_01->bpm_->CheckAllUnpinned());
+
+  int count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(row_nums / 2, count);
+  count = 0;
+  auto *bptree = reinterpret_cast<BPlusTreeIndex *>(index);
+  for (auto it = bptree->GetBeginIterator(); it != bptree->GetEndIterator(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(row_nums / 2, count);
+  ASSERT_TRUE(db_01->bpm_->CheckAllUnpinned());
+  delete db_01;
+
+  // Loading the catalog back must not leave its meta pages pinned.
+  auto *db_02 = new DBStorageEngine(db_name, false);
+  // The warm-up pins the pages it is reading, stop it before checking the pins.
+  db_02->bpm_->StopWarmup();
+  ASSERT_TRUE(db_02->bpm_->CheckAllUnpinned());
+  ASSERT_EQ(DB_SUCCESS, db_02->catalog_mgr_->GetTable("t", table_info));
+  count = 0;
+  for (auto it = table_info->GetTableHeap()->Begin(nullptr); it != table_info->GetTableHeap()->End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(row_nums / 2, count);
+  ASSERT_TRUE(db_02->bpm_->CheckAllUnpinned());
+  delete db_02;
+  // DBStorageEngine keeps its files under ./databases/, the dump of the resident pages next to the db file.
+  remove(("./databases/" + db_name).c_str());
+  remove(("./databases/." + db_name + ".bpdump").c_str());
+}
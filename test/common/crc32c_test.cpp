@@ -0,0 +1,60 @@
+#include "common/crc32c.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+TEST(Crc32cTest, KnownValuesTest) {
+  const char *check = "123456789";
+  EXPECT_EQ(0xe3069283, Crc32c(check, 9));
+  EXPECT_EQ(0xe3069283, Crc32cPortable(check, 9));
+  std::vector<char> zeros(32, 0);
+  EXPECT_EQ(0x8a9136aa, Crc32c(zeros.data(), zeros.size()));
+  std::vector<char> ones(32, static_cast<char>(0xff));
+  EXPECT_EQ(0x62a8ab43, Crc32c(ones.data(), ones.size()));
+  EXPECT_EQ(0, Crc32c(check, 0));
+}
+
+TEST(Crc32cTest, MatchesPortableTest) {
+  std::default_random_engine rng(0);
+  std::vector<char> buffer(3 * PAGE_SIZE);
+  for (auto &c : buffer) {
+    c = static_cast<char>(rng());
+  }
+  std::uniform_int_distribution<size_t> dist(0, 2 * PAGE_SIZE);
+  // Random offsets and lengths, across the three stream path and the tails.
+  for (int i = 0; i < 2000; i++) {
+    size_t offset = dist(rng) % 64;
+    size_t len = i < 20 ? PAGE_SIZE * (i % 3) + i : dist(rng);
+    uint32_t crc = Crc32c(buffer.data() + offset, len);
+    ASSERT_EQ(Crc32cPortable(buffer.data() + offset, len), crc) << "offset " << offset << " len " << len;
+    // Checksumming in two pieces gives the same result.
+    size_t split = len / 3;
+    ASSERT_EQ(crc, Crc32c(buffer.data() + offset + split, len - split, Crc32c(buffer.data() + offset, split)));
+  }
+}
+
+TEST(Crc32cTest, ThroughputBenchmarkTest) {
+  std::vector<char> page(PAGE_SIZE, 'x');
+  const int rounds = 20000;
+  for (bool hardware : {true, false}) {
+    if (hardware && !Crc32cIsHardwareAccelerated()) {
+      continue;
+    }
+    uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+      page[0] = static_cast<char>(i);
+      sink ^= hardware ? Crc32c(page.data(), PAGE_USABLE_SIZE) : Crc32cPortable(page.data(), PAGE_USABLE_SIZE);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG(INFO) << (hardware ? "sse4.2" : "portable") << ": " << seconds / rounds * 1e9 << " ns per page, "
+              << rounds * static_cast<double>(PAGE_SIZE) / seconds / (1 << 30) << " GiB/s (" << sink << ")"
+              << std::endl;
+  }
+}
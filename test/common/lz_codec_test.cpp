@@ -0,0 +1,109 @@
+#include "common/lz_codec.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace {
+/** A page of rows with a key, a random number and a CHAR(64) column padded with spaces, as a table page holds. */
+std::vector<char> MakeRowsPage(std::default_random_engine &rng) {
+  std::vector<char> page(PAGE_SIZE, 0);
+  std::uniform_int_distribution<int> dist(0, 1 << 20);
+  for (size_t pos = 0, key = 0; pos + 80 <= page.size(); pos += 80, key++) {
+    std::string name = "name_" + std::to_string(dist(rng) % 100);
+    memcpy(page.data() + pos, &key, sizeof(key));
+    int value = dist(rng);
+    memcpy(page.data() + pos + 8, &value, sizeof(value));
+    memset(page.data() + pos + 16, ' ', 64);
+    memcpy(page.data() + pos + 16, name.data(), name.size());
+  }
+  return page;
+}
+}  // namespace
+
+TEST(LzCodecTest, RoundTripTest) {
+  std::default_random_engine rng(0);
+  std::vector<std::vector<char>> inputs;
+  inputs.emplace_back();
+  inputs.emplace_back(1, 'a');
+  inputs.emplace_back(PAGE_SIZE, 0);
+  inputs.emplace_back(PAGE_SIZE, 'x');
+  inputs.push_back(MakeRowsPage(rng));
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &c : random) {
+    c = static_cast<char>(rng());
+  }
+  inputs.push_back(random);
+  // Long literal runs and long matches, whose lengths take extra bytes, and an overlapping pattern.
+  std::vector<char> mixed(3 * PAGE_SIZE);
+  for (size_t i = 0; i < mixed.size(); i++) {
+    mixed[i] = i < 1000 ? static_cast<char>(rng()) : (i < 2000 ? 'y' : static_cast<char>("abc"[i % 3]));
+  }
+  inputs.push_back(mixed);
+  for (size_t n = 0; n < 20; n++) {
+    inputs.emplace_back(random.begin(), random.begin() + n);
+  }
+  for (const auto &input : inputs) {
+    std::vector<char> compressed(input.size() + input.size() / 255 + 16);
+    size_t size = LzCompress(input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_GT(size, 0);
+    std::vector<char> output(input.size());
+    ASSERT_TRUE(LzDecompress(compressed.data(), size, output.data(), output.size()));
+    EXPECT_EQ(input, output);
+  }
+  EXPECT_LT(LzCompress(inputs[3].data(), PAGE_SIZE, random.data(), PAGE_SIZE), 40);
+
+  // Scenario: data not fitting in the capacity is reported, malformed data is rejected without overflowing.
+  std::vector<char> small(PAGE_SIZE / 2);
+  EXPECT_EQ(0, LzCompress(random.data(), PAGE_SIZE, small.data(), small.size()));
+  std::vector<char> compressed(PAGE_SIZE);
+  size_t size = LzCompress(inputs[4].data(), PAGE_SIZE, compressed.data(), compressed.size());
+  std::vector<char> output(PAGE_SIZE);
+  EXPECT_FALSE(LzDecompress(compressed.data(), size, output.data(), PAGE_SIZE - 1));
+  EXPECT_FALSE(LzDecompress(compressed.data(), size - 1, output.data(), PAGE_SIZE));
+  for (size_t i = 0; i < 1000; i++) {
+    std::vector<char> garbage(compressed.begin(), compressed.begin() + size);
+    garbage[rng() % size] = static_cast<char>(rng());
+    LzDecompress(garbage.data(), garbage.size(), output.data(), output.size());
+  }
+}
+
+TEST(LzCodecTest, ThroughputBenchmarkTest) {
+  std::default_random_engine rng(0);
+  const int num_pages = 256;
+  const int rounds = 20;
+  std::vector<std::vector<char>> pages;
+  for (int i = 0; i < num_pages; i++) {
+    pages.push_back(MakeRowsPage(rng));
+  }
+  std::vector<std::vector<char>> compressed(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<size_t> sizes(num_pages);
+  size_t total = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < num_pages; i++) {
+      sizes[i] = LzCompress(pages[i].data(), PAGE_SIZE, compressed[i].data(), PAGE_SIZE);
+    }
+  }
+  double compress_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::vector<char> output(PAGE_SIZE);
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_TRUE(LzDecompress(compressed[i].data(), sizes[i], output.data(), PAGE_SIZE));
+    }
+  }
+  double decompress_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (size_t size : sizes) {
+    total += size;
+  }
+  double mib = static_cast<double>(num_pages) * rounds * PAGE_SIZE / (1 << 20);
+  LOG(INFO) << "row pages compressed to " << 100.0 * total / (num_pages * PAGE_SIZE) << "%, compress "
+            << mib / compress_seconds << " MiB/s, decompress " << mib / decompress_seconds << " MiB/s" << std::endl;
+}
@@ -0,0 +1,148 @@
+#include "common/rwlatch.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace {
+/**
+ * The previous mutex and condition variable based latch, kept as the baseline of the benchmark.
+ */
+class MutexReaderWriterLatch {
+ public:
+  void WLock() {
+    std::unique_lock<std::mutex> latch(mutex_);
+    reader_.wait(latch, [this]() { return !writer_entered_; });
+    writer_entered_ = true;
+    writer_.wait(latch, [this]() { return reader_count_ == 0; });
+  }
+
+  void WUnlock() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    writer_entered_ = false;
+    reader_.notify_all();
+  }
+
+  void RLock() {
+    std::unique_lock<std::mutex> latch(mutex_);
+    reader_.wait(latch, [this]() { return !writer_entered_; });
+    reader_count_++;
+  }
+
+  void RUnlock() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (--reader_count_ == 0 && writer_entered_) {
+      writer_.notify_one();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable writer_;
+  std::condition_variable reader_;
+  uint32_t reader_count_{0};
+  bool writer_entered_{false};
+};
+
+/**
+ * Every thread takes the latch ops_per_thread times, one time in write_every in write mode, and reads or increments
+ * a shared counter under it.
+ * @return the throughput in million latch operations per second
+ */
+template <class Latch>
+double RunContention(Latch &latch, int num_threads, int ops_per_thread, int write_every, uint64_t *counter) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&latch, ops_per_thread, write_every, counter, t]() {
+      volatile uint64_t sink = 0;
+      for (int i = 0; i < ops_per_thread; i++) {
+        if ((i + t) % write_every == 0) {
+          latch.WLock();
+          (*counter)++;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          sink = *counter;
+          latch.RUnlock();
+        }
+      }
+      (void)sink;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return num_threads * ops_per_thread / seconds / 1e6;
+}
+}  // namespace
+
+TEST(RWLatchTest, SharedAndExclusiveTest) {
+  ReaderWriterLatch latch;
+  // Readers share the latch.
+  latch.RLock();
+  std::atomic<bool> read{false};
+  std::thread reader([&]() {
+    latch.RLock();
+    read = true;
+    latch.RUnlock();
+  });
+  reader.join();
+  EXPECT_TRUE(read);
+
+  // A writer waits for the reader, and a reader arriving after it waits for the writer.
+  std::atomic<int> step{0};
+  std::thread writer([&]() {
+    latch.WLock();
+    EXPECT_EQ(1, ++step);
+    latch.WUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::thread late_reader([&]() {
+    latch.RLock();
+    EXPECT_EQ(2, ++step);
+    latch.RUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(0, step);
+  latch.RUnlock();
+  writer.join();
+  late_reader.join();
+  EXPECT_EQ(2, step);
+}
+
+TEST(RWLatchTest, MutualExclusionTest) {
+  ReaderWriterLatch latch;
+  const int num_threads = 8;
+  const int ops_per_thread = 20000;
+  uint64_t counter = 0;
+  RunContention(latch, num_threads, ops_per_thread, 4, &counter);
+  EXPECT_EQ(num_threads * ops_per_thread / 4, counter);
+}
+
+TEST(RWLatchTest, ContentionBenchmarkTest) {
+  EXPECT_LE(sizeof(ReaderWriterLatch), 8);
+  LOG(INFO) << "latch size: ReaderWriterLatch " << sizeof(ReaderWriterLatch) << " bytes, mutex based "
+            << sizeof(MutexReaderWriterLatch) << " bytes" << std::endl;
+  const int ops_per_thread = 20000;
+  for (int num_threads : {1, 2, 4, 8, 16, 32}) {
+    for (int write_every : {10, 2}) {
+      ReaderWriterLatch latch;
+      MutexReaderWriterLatch baseline;
+      uint64_t counter = 0;
+      uint64_t baseline_counter = 0;
+      double mops = RunContention(latch, num_threads, ops_per_thread, write_every, &counter);
+      double baseline_mops = RunContention(baseline, num_threads, ops_per_thread, write_every, &baseline_counter);
+      EXPECT_EQ(baseline_counter, counter);
+      LOG(INFO) << num_threads << " threads, 1/" << write_every << " writes: ReaderWriterLatch " << mops
+                << " Mops/s, mutex based " << baseline_mops << " Mops/s" << std::endl;
+    }
+  }
+}
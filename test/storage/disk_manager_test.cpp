@@ -1,7 +1,18 @@
 #include "storage/disk_manager.h"
 #include "glog/logging.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
+#include "common/crc32c.h"
 #include "gtest/gtest.h"
 
 TEST(DiskManagerTest, BitMapPageTest) {
@@ -67,4 +78,613 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
   LOG(WARNING) << "TEST(DiskManagerTest, FreePageAllocationTest) success!" << std::endl;
-}
\ No newline at end of file
+}
+TEST(DiskManagerTest, ConcurrentReadWriteTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_threads * pages_per_thread; i++) {
+    page_ids.push_back(disk_mgr->AllocatePage());
+  }
+  // A page never written reads as zeros.
+  char data[PAGE_SIZE];
+  memset(data, 1, PAGE_SIZE);
+  disk_mgr->ReadPage(page_ids.back(), data);
+  EXPECT_EQ(0, data[0]);
+  EXPECT_EQ(0, data[PAGE_SIZE - 1]);
+
+  // Every thread writes and reads back its own pages, all of them at the same time.
+  std::vector<std::thread> threads;
+  std::atomic<int> num_errors{0};
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      char buf[PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = t * pages_per_thread; i < (t + 1) * pages_per_thread; i++) {
+          memset(buf, i + round, PAGE_SIZE);
+          disk_mgr->WritePage(page_ids[i], buf);
+        }
+        for (int i = t * pages_per_thread; i < (t + 1) * pages_per_thread; i++) {
+          disk_mgr->ReadPage(page_ids[i], buf);
+          if (buf[0] != static_cast<char>(i + round) || buf[PAGE_USABLE_SIZE - 1] != static_cast<char>(i + round)) {
+            num_errors++;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, num_errors);
+  delete disk_mgr;
+
+  // The pages and the allocation survive reopening the file.
+  disk_mgr = new DiskManager(db_name);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(num_threads * pages_per_thread, meta_page->GetAllocatedPages());
+  disk_mgr->ReadPage(page_ids.back(), data);
+  EXPECT_EQ(static_cast<char>(page_ids.size() - 1 + 3), data[PAGE_SIZE / 2]);
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, SyncTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  char data[PAGE_SIZE];
+  memset(data, 1, PAGE_SIZE);
+
+  // Scenario: periodic durability issues no sync by itself, and the meta page is written back by Sync only.
+  auto *disk_mgr = new DiskManager(db_name, DurabilityMode::kPeriodic);
+  page_id_t page_id = disk_mgr->AllocatePage();
+  disk_mgr->WritePage(page_id, data);
+  EXPECT_EQ(0, disk_mgr->GetNumSyncs());
+  {
+    auto *reader = new DiskManager(db_name);
+    EXPECT_EQ(0, reinterpret_cast<DiskFileMetaPage *>(reader->GetMetaData())->GetAllocatedPages());
+    delete reader;
+  }
+  disk_mgr->Sync();
+  EXPECT_EQ(1, disk_mgr->GetNumSyncs());
+  // Nothing was written since, there is nothing to sync.
+  disk_mgr->Sync();
+  EXPECT_EQ(1, disk_mgr->GetNumSyncs());
+  {
+    auto *reader = new DiskManager(db_name);
+    EXPECT_EQ(1, reinterpret_cast<DiskFileMetaPage *>(reader->GetMetaData())->GetAllocatedPages());
+    delete reader;
+  }
+
+  // Scenario: concurrent syncs are grouped, there are never more fdatasync calls than Sync calls.
+  const int num_threads = 8;
+  const int syncs_per_thread = 16;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < syncs_per_thread; i++) {
+        disk_mgr->WritePage(page_id, data);
+        disk_mgr->Sync();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  uint64_t num_syncs = disk_mgr->GetNumSyncs() - 1;
+  EXPECT_GT(num_syncs, 0);
+  EXPECT_LE(num_syncs, num_threads * syncs_per_thread);
+  LOG(INFO) << num_threads * syncs_per_thread << " syncs served by " << num_syncs << " fdatasync calls" << std::endl;
+
+  // Scenario: per-write durability syncs every write.
+  disk_mgr->SetDurabilityMode(DurabilityMode::kPerWrite);
+  uint64_t before = disk_mgr->GetNumSyncs();
+  for (int i = 0; i < 4; i++) {
+    disk_mgr->WritePage(page_id, data);
+  }
+  EXPECT_EQ(before + 4, disk_mgr->GetNumSyncs());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AsyncIoTest) {
+  std::string db_name = "disk_test.db";
+  for (bool async : {true, false}) {
+    remove(db_name.c_str());
+    auto *disk_mgr = new DiskManager(db_name);
+    if (!async) {
+      disk_mgr->DisableAsyncIo();
+    }
+    const int num_pages = 300;
+    std::vector<page_id_t> page_ids;
+    std::vector<char> pages(num_pages * PAGE_SIZE);
+    IoBatch batch;
+    for (int i = 0; i < num_pages; i++) {
+      page_ids.push_back(disk_mgr->AllocatePage());
+      memset(pages.data() + i * PAGE_SIZE, i % 128, PAGE_SIZE);
+      disk_mgr->WritePageAsync(batch, page_ids[i], pages.data() + i * PAGE_SIZE);
+    }
+    // More I/Os than the depth of the ring.
+    disk_mgr->SubmitBatch(batch);
+    disk_mgr->WaitBatch(batch);
+    // The checksum is stamped into copies, the pages queued are left untouched.
+    for (int i = 0; i < num_pages; i++) {
+      EXPECT_EQ(i % 128, pages[i * PAGE_SIZE + PAGE_SIZE - 1]);
+    }
+
+    // A write linked to a read of another page into the same buffer, as done when evicting a dirty page.
+    char frame[PAGE_SIZE];
+    memset(frame, 'x', PAGE_SIZE);
+    batch.Clear();
+    disk_mgr->WritePageAsync(batch, page_ids[0], frame);
+    batch.LinkLast();
+    disk_mgr->ReadPageAsync(batch, page_ids[1], frame);
+    page_id_t unwritten = disk_mgr->AllocatePage();
+    char zeros[PAGE_SIZE];
+    memset(zeros, 1, PAGE_SIZE);
+    disk_mgr->ReadPageAsync(batch, unwritten, zeros);
+    disk_mgr->SubmitBatch(batch);
+    disk_mgr->WaitBatch(batch);
+    EXPECT_EQ(1, frame[0]);
+    EXPECT_EQ(1, frame[PAGE_USABLE_SIZE - 1]);
+    EXPECT_EQ(0, zeros[0]);
+    disk_mgr->ReadPage(page_ids[0], frame);
+    EXPECT_EQ('x', frame[PAGE_SIZE / 2]);
+
+    batch.Clear();
+    std::vector<char> read_back(num_pages * PAGE_SIZE);
+    for (int i = 1; i < num_pages; i++) {
+      disk_mgr->ReadPageAsync(batch, page_ids[i], read_back.data() + i * PAGE_SIZE);
+    }
+    disk_mgr->SubmitBatch(batch);
+    disk_mgr->WaitBatch(batch);
+    for (int i = 1; i < num_pages; i++) {
+      EXPECT_EQ(0, memcmp(pages.data() + i * PAGE_SIZE, read_back.data() + i * PAGE_SIZE, PAGE_USABLE_SIZE));
+    }
+    delete disk_mgr;
+  }
+  remove(db_name.c_str());
+}
+
+/**
+ * Random page reads issued in batches of 1 to 64, with the page cache dropped before every run.
+ */
+TEST(DiskManagerTest, AsyncIoBenchmarkTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const int num_pages = 4096;
+  const int num_reads = 2048;
+  std::vector<page_id_t> page_ids;
+  char data[PAGE_SIZE];
+  memset(data, 1, PAGE_SIZE);
+  for (int i = 0; i < num_pages; i++) {
+    page_ids.push_back(disk_mgr->AllocatePage());
+    disk_mgr->WritePage(page_ids.back(), data);
+  }
+  disk_mgr->Sync();
+  bool has_async_io = disk_mgr->IsAsyncIoEnabled();
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<int> dist(0, num_pages - 1);
+  std::vector<char> buffers(64 * PAGE_SIZE);
+  for (bool async : {true, false}) {
+    if (async && !has_async_io) {
+      continue;
+    }
+    if (!async) {
+      disk_mgr->DisableAsyncIo();
+    }
+    for (int depth : {1, 4, 16, 64}) {
+      int fd = open(db_name.c_str(), O_RDONLY);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+      auto start = std::chrono::steady_clock::now();
+      IoBatch batch;
+      for (int done = 0; done < num_reads; done += depth) {
+        batch.Clear();
+        for (int i = 0; i < depth; i++) {
+          disk_mgr->ReadPageAsync(batch, page_ids[dist(rng)], buffers.data() + i * PAGE_SIZE);
+        }
+        disk_mgr->SubmitBatch(batch);
+        disk_mgr->WaitBatch(batch);
+        ASSERT_EQ(1, buffers[0]);
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      LOG(INFO) << (async ? "io_uring" : "pread") << " queue depth " << depth << ": " << num_reads / seconds
+                << " pages/s" << std::endl;
+    }
+  }
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, DirectIoTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name, DurabilityMode::kPeriodic, true);
+  LOG(INFO) << "O_DIRECT " << (disk_mgr->IsDirectIo() ? "enabled" : "not supported") << std::endl;
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(disk_mgr->GetMetaData()) % PAGE_SIZE);
+  // An aligned buffer goes to the file as is, an unaligned one through the bounce buffer.
+  std::unique_ptr<char, decltype(&free)> aligned(static_cast<char *>(aligned_alloc(PAGE_SIZE, 2 * PAGE_SIZE)), &free);
+  std::vector<char> unaligned_storage(PAGE_SIZE + 1);
+  char *unaligned = unaligned_storage.data() + 1;
+  page_id_t p0 = disk_mgr->AllocatePage();
+  page_id_t p1 = disk_mgr->AllocatePage();
+  memset(aligned.get(), 'a', PAGE_SIZE);
+  memset(unaligned, 'u', PAGE_SIZE);
+  disk_mgr->WritePage(p0, aligned.get());
+  disk_mgr->WritePage(p1, unaligned);
+  disk_mgr->ReadPage(p1, aligned.get());
+  EXPECT_EQ('u', aligned.get()[PAGE_USABLE_SIZE - 1]);
+  disk_mgr->ReadPage(p0, unaligned);
+  EXPECT_EQ('a', unaligned[0]);
+  EXPECT_EQ('a', unaligned[PAGE_USABLE_SIZE - 1]);
+
+  // In a batch an unaligned buffer is rejected by the kernel and the I/O redone synchronously.
+  IoBatch batch;
+  memset(unaligned, 'v', PAGE_SIZE);
+  disk_mgr->WritePageAsync(batch, p0, unaligned);
+  disk_mgr->ReadPageAsync(batch, p1, aligned.get() + PAGE_SIZE);
+  disk_mgr->SubmitBatch(batch);
+  disk_mgr->WaitBatch(batch);
+  EXPECT_EQ('u', aligned.get()[PAGE_SIZE + PAGE_USABLE_SIZE - 1]);
+  batch.Clear();
+  disk_mgr->ReadPageAsync(batch, p0, unaligned);
+  disk_mgr->ReadPageAsync(batch, p1, aligned.get());
+  memset(unaligned, 0, PAGE_SIZE);
+  disk_mgr->SubmitBatch(batch);
+  disk_mgr->WaitBatch(batch);
+  EXPECT_EQ('v', unaligned[PAGE_SIZE / 2]);
+  delete disk_mgr;
+
+  // The meta page and the data written with O_DIRECT are read back by buffered I/O.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_FALSE(disk_mgr->IsPageFree(p1));
+  disk_mgr->ReadPage(p0, aligned.get());
+  EXPECT_EQ('v', aligned.get()[0]);
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, BitmapCacheTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 100; i++) {
+    page_ids.push_back(disk_mgr->AllocatePage());
+    EXPECT_EQ(i, page_ids.back());
+  }
+  disk_mgr->DeAllocatePage(page_ids[10]);
+  disk_mgr->DeAllocatePage(page_ids[20]);
+  EXPECT_TRUE(disk_mgr->IsPageFree(page_ids[10]));
+  EXPECT_FALSE(disk_mgr->IsPageFree(page_ids[11]));
+  EXPECT_TRUE(disk_mgr->IsPageFree(DiskManager::BITMAP_SIZE * 3));
+  EXPECT_FALSE(disk_mgr->IsPageFree(-1));
+
+  // The bitmap of extent 0 (physical page 1) is only written back by Sync.
+  int fd = open(db_name.c_str(), O_RDONLY);
+  char bitmap[PAGE_SIZE];
+  memset(bitmap, 0, PAGE_SIZE);
+  pread(fd, bitmap, PAGE_SIZE, PAGE_SIZE);
+  EXPECT_EQ(0, reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap)->page_allocated_);
+  disk_mgr->Sync();
+  ASSERT_EQ(PAGE_SIZE, pread(fd, bitmap, PAGE_SIZE, PAGE_SIZE));
+  EXPECT_EQ(98, reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap)->page_allocated_);
+  close(fd);
+
+  // The freed pages are allocated again first, and the allocation state survives a restart.
+  EXPECT_EQ(page_ids[10], disk_mgr->AllocatePage());
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_FALSE(disk_mgr->IsPageFree(page_ids[10]));
+  EXPECT_TRUE(disk_mgr->IsPageFree(page_ids[20]));
+  EXPECT_EQ(page_ids[20], disk_mgr->AllocatePage());
+  EXPECT_EQ(100, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, SegmentTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  // Scenario: two segments allocating in turns get contiguous runs, the other allocations skip the runs.
+  auto *a = new PageSegment();
+  auto *b = new PageSegment();
+  std::vector<page_id_t> a_pages, b_pages, other_pages;
+  for (int i = 0; i < 2 * SEGMENT_RUN_PAGES; i++) {
+    a_pages.push_back(disk_mgr->AllocatePage(a));
+    b_pages.push_back(disk_mgr->AllocatePage(b));
+    other_pages.push_back(disk_mgr->AllocatePage());
+  }
+  for (int i = 1; i < 2 * SEGMENT_RUN_PAGES; i++) {
+    if (i % SEGMENT_RUN_PAGES != 0) {
+      EXPECT_EQ(a_pages[i - 1] + 1, a_pages[i]);
+      EXPECT_EQ(b_pages[i - 1] + 1, b_pages[i]);
+    }
+  }
+  EXPECT_EQ(0, a_pages[0] % SEGMENT_RUN_PAGES);
+  EXPECT_EQ(0, b_pages[0] % SEGMENT_RUN_PAGES);
+  std::unordered_set<page_id_t> all(a_pages.begin(), a_pages.end());
+  all.insert(b_pages.begin(), b_pages.end());
+  all.insert(other_pages.begin(), other_pages.end());
+  EXPECT_EQ(6 * SEGMENT_RUN_PAGES, all.size());
+  for (page_id_t page_id : other_pages) {
+    EXPECT_NE(a_pages[0] / SEGMENT_RUN_PAGES, page_id / SEGMENT_RUN_PAGES);
+    EXPECT_NE(b_pages.back() / SEGMENT_RUN_PAGES, page_id / SEGMENT_RUN_PAGES);
+  }
+
+  // Scenario: a page freed in the current run of a segment is reused by it, and the unused pages of the run of a
+  // destroyed segment go back to the other allocations.
+  disk_mgr->DeAllocatePage(a_pages.back() - 1);
+  EXPECT_EQ(a_pages.back() - 1, disk_mgr->AllocatePage(a));
+  page_id_t next_b = disk_mgr->AllocatePage(b);
+  EXPECT_EQ(0, next_b % SEGMENT_RUN_PAGES);
+  delete b;
+  std::unordered_set<page_id_t> reused;
+  for (int i = 0; i < SEGMENT_RUN_PAGES; i++) {
+    reused.insert(disk_mgr->AllocatePage());
+  }
+  EXPECT_EQ(1, reused.count(next_b + 1));
+  delete a;
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ChecksumTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  EXPECT_EQ(ChecksumMode::kWarn, disk_mgr->GetChecksumMode());
+  char data[PAGE_SIZE];
+  page_id_t page_id = disk_mgr->AllocatePage();
+  memset(data, 'c', PAGE_SIZE);
+  disk_mgr->WritePage(page_id, data);
+  // The checksum is stamped into a copy, the page of the caller is left alone.
+  EXPECT_EQ('c', data[PAGE_SIZE - 1]);
+  disk_mgr->ReadPage(page_id, data);
+  EXPECT_EQ(Crc32c(data, PAGE_USABLE_SIZE), *reinterpret_cast<uint32_t *>(data + PAGE_USABLE_SIZE));
+  // A page never written reads as zeros without a failure.
+  page_id_t unwritten = disk_mgr->AllocatePage();
+  disk_mgr->WritePage(disk_mgr->AllocatePage(), data);
+  disk_mgr->ReadPage(unwritten, data);
+  disk_mgr->ReadPage(page_id, data);
+  EXPECT_EQ(0, disk_mgr->GetNumChecksumFailures());
+
+  // Scenario: a byte of the page flipped behind the back of the disk manager is detected by reads, sync or batched.
+  disk_mgr->Sync();
+  int fd = open(db_name.c_str(), O_WRONLY);
+  char corrupted = 'd';
+  // logical page 0 is physical page 2, after the meta page and the bitmap of extent 0
+  ASSERT_EQ(1, pwrite(fd, &corrupted, 1, (page_id + 2) * PAGE_SIZE + 100));
+  close(fd);
+  disk_mgr->ReadPage(page_id, data);
+  EXPECT_EQ('d', data[100]);
+  EXPECT_EQ(1, disk_mgr->GetNumChecksumFailures());
+  IoBatch batch;
+  disk_mgr->ReadPageAsync(batch, page_id, data);
+  char zeros[PAGE_SIZE];
+  disk_mgr->ReadPageAsync(batch, unwritten, zeros);
+  disk_mgr->SubmitBatch(batch);
+  disk_mgr->WaitBatch(batch);
+  EXPECT_EQ(2, disk_mgr->GetNumChecksumFailures());
+
+  // Scenario: with checks off the page is read as is, and writing it again makes it valid.
+  disk_mgr->SetChecksumMode(ChecksumMode::kOff);
+  disk_mgr->ReadPage(page_id, data);
+  EXPECT_EQ(2, disk_mgr->GetNumChecksumFailures());
+  disk_mgr->WritePage(page_id, data);
+  disk_mgr->SetChecksumMode(ChecksumMode::kWarn);
+  disk_mgr->ReadPage(page_id, data);
+  EXPECT_EQ(2, disk_mgr->GetNumChecksumFailures());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+/**
+ * Reads of a 4 KiB page hot in the page cache, the cheapest read path, with and without checking the checksum.
+ */
+TEST(DiskManagerTest, ChecksumBenchmarkTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const int num_pages = 64;
+  const int num_reads = 200000;
+  char data[PAGE_SIZE];
+  memset(data, 1, PAGE_SIZE);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_ids.push_back(disk_mgr->AllocatePage());
+    disk_mgr->WritePage(page_ids.back(), data);
+  }
+  double seconds[2];
+  for (ChecksumMode mode : {ChecksumMode::kOff, ChecksumMode::kWarn}) {
+    disk_mgr->SetChecksumMode(mode);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_reads; i++) {
+      disk_mgr->ReadPage(page_ids[i % num_pages], data);
+    }
+    int index = mode == ChecksumMode::kOff ? 0 : 1;
+    seconds[index] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG(INFO) << (index == 0 ? "unchecked" : "checked") << " reads: " << num_reads / seconds[index] << " pages/s"
+              << std::endl;
+  }
+  LOG(INFO) << "checksum overhead " << (seconds[1] / seconds[0] - 1) * 100 << "% ("
+            << (Crc32cIsHardwareAccelerated() ? "sse4.2" : "portable") << ")" << std::endl;
+  EXPECT_EQ(0, disk_mgr->GetNumChecksumFailures());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  disk_mgr->SetPageCompression(true);
+  EXPECT_TRUE(disk_mgr->IsPageCompressionEnabled());
+  std::default_random_engine rng(0);
+  char compressible[PAGE_SIZE];
+  char random[PAGE_SIZE];
+  char data[PAGE_SIZE];
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    compressible[i] = static_cast<char>("name_"[i % 5]);
+    random[i] = static_cast<char>(rng());
+  }
+  page_id_t p0 = disk_mgr->AllocatePage();
+  page_id_t p1 = disk_mgr->AllocatePage();
+  disk_mgr->WritePage(p0, compressible);
+  disk_mgr->WritePage(p1, random);
+  EXPECT_EQ(1, disk_mgr->GetNumCompressedPages());
+  disk_mgr->ReadPage(p0, data);
+  EXPECT_EQ(0, memcmp(compressible, data, PAGE_USABLE_SIZE));
+  disk_mgr->ReadPage(p1, data);
+  EXPECT_EQ(0, memcmp(random, data, PAGE_USABLE_SIZE));
+
+  // Scenario: the home slot of a page moved to the compressed page file is kept until the map pointing to its new slot
+  // is synced, so that a crash in between still finds the page at home.
+  page_id_t p2 = disk_mgr->AllocatePage();
+  disk_mgr->WritePage(p2, random);
+  disk_mgr->Sync();
+  disk_mgr->WritePage(p2, compressible);
+  int fd = open(db_name.c_str(), O_RDONLY);
+  ASSERT_EQ(PAGE_SIZE, pread(fd, data, PAGE_SIZE, (p2 + 2) * PAGE_SIZE));
+  close(fd);
+  EXPECT_EQ(0, memcmp(random, data, PAGE_USABLE_SIZE));
+  disk_mgr->Sync();
+  disk_mgr->ReadPage(p2, data);
+  EXPECT_EQ(0, memcmp(compressible, data, PAGE_USABLE_SIZE));
+  disk_mgr->WritePage(p2, random);
+  disk_mgr->ReadPage(p2, data);
+  EXPECT_EQ(0, memcmp(random, data, PAGE_USABLE_SIZE));
+
+  // Scenario: a page moves between its home slot and slots of various sizes, the last version is read.
+  memcpy(data, compressible, PAGE_SIZE);
+  memcpy(data, random, PAGE_SIZE / 4);
+  disk_mgr->WritePage(p0, data);
+  EXPECT_EQ(1, disk_mgr->GetNumCompressedPages());
+  disk_mgr->WritePage(p0, random);
+  EXPECT_EQ(0, disk_mgr->GetNumCompressedPages());
+  disk_mgr->ReadPage(p0, data);
+  EXPECT_EQ(0, memcmp(random, data, PAGE_USABLE_SIZE));
+  disk_mgr->WritePage(p0, compressible);
+  disk_mgr->WritePage(p1, compressible);
+  EXPECT_EQ(2, disk_mgr->GetNumCompressedPages());
+  IoBatch batch;
+  disk_mgr->ReadPageAsync(batch, p0, data);
+  disk_mgr->ReadPageAsync(batch, p1, random);
+  disk_mgr->SubmitBatch(batch);
+  disk_mgr->WaitBatch(batch);
+  EXPECT_EQ(0, memcmp(compressible, data, PAGE_USABLE_SIZE));
+  EXPECT_EQ(0, memcmp(compressible, random, PAGE_USABLE_SIZE));
+
+  // Scenario: the slots of freed pages are reused once the map is written back, the file does not grow.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 100; i++) {
+    page_ids.push_back(disk_mgr->AllocatePage());
+    disk_mgr->WritePage(page_ids.back(), compressible);
+  }
+  disk_mgr->Sync();
+  int64_t zdata_size = std::filesystem::file_size(db_name + ".zdata");
+  for (page_id_t page_id : page_ids) {
+    disk_mgr->DeAllocatePage(page_id);
+  }
+  EXPECT_EQ(2, disk_mgr->GetNumCompressedPages());
+  disk_mgr->Sync();
+  for (int i = 0; i < 100; i++) {
+    disk_mgr->WritePage(disk_mgr->AllocatePage(), compressible);
+  }
+  disk_mgr->Sync();
+  EXPECT_EQ(zdata_size, std::filesystem::file_size(db_name + ".zdata"));
+  EXPECT_EQ(102, disk_mgr->GetNumCompressedPages());
+  delete disk_mgr;
+
+  // Scenario: compressed pages are read after a restart with compression disabled, and written back uncompressed.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_FALSE(disk_mgr->IsPageCompressionEnabled());
+  EXPECT_EQ(102, disk_mgr->GetNumCompressedPages());
+  disk_mgr->ReadPage(p1, data);
+  EXPECT_EQ(0, memcmp(compressible, data, PAGE_USABLE_SIZE));
+  disk_mgr->WritePage(p1, data);
+  EXPECT_EQ(101, disk_mgr->GetNumCompressedPages());
+  disk_mgr->ReadPage(p1, data);
+  EXPECT_EQ(0, memcmp(compressible, data, PAGE_USABLE_SIZE));
+  EXPECT_EQ(0, disk_mgr->GetNumChecksumFailures());
+
+  // Scenario: a compressed page which does not decompress is reported and read as zeros, not half decompressed.
+  std::vector<char> zeros(std::filesystem::file_size(db_name + ".zdata"));
+  fd = open((db_name + ".zdata").c_str(), O_WRONLY);
+  ASSERT_EQ(static_cast<ssize_t>(zeros.size()), pwrite(fd, zeros.data(), zeros.size(), 0));
+  close(fd);
+  disk_mgr->ReadPage(p0, data);
+  EXPECT_EQ(1, disk_mgr->GetNumChecksumFailures());
+  EXPECT_TRUE(std::all_of(data, data + PAGE_SIZE, [](char c) { return c == 0; }));
+  delete disk_mgr;
+
+  // Scenario: the compressed page file of a removed db is not used by a new db of the same name.
+  remove(db_name.c_str());
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_EQ(0, disk_mgr->GetNumCompressedPages());
+  disk_mgr->ReadPage(p0, data);
+  EXPECT_EQ(0, data[0]);
+  delete disk_mgr;
+  remove(db_name.c_str());
+  remove((db_name + ".zdata").c_str());
+  remove((db_name + ".zmap").c_str());
+}
+
+TEST(DiskManagerTest, MetaPageChainTest) {
+  const uint32_t extents_per_meta_page = DiskManager::EXTENTS_PER_META_PAGE;
+  const page_id_t first_page_id = extents_per_meta_page * DiskManager::BITMAP_SIZE;
+  EXPECT_GT(static_cast<int64_t>(MAX_VALID_PAGE_ID) * PAGE_SIZE, 7LL << 40);
+  // A sparse file whose first meta page counts all of its extents full, their bitmaps are never read.
+  std::string db_name = "disk_test.db";
+  remove(db_name.c_str());
+  char meta[PAGE_SIZE];
+  memset(meta, 0, PAGE_SIZE);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta);
+  meta_page->num_extents_ = extents_per_meta_page;
+  meta_page->num_allocated_pages_ = first_page_id;
+  for (uint32_t i = 0; i < extents_per_meta_page; i++) {
+    meta_page->extent_used_page_[i] = DiskManager::BITMAP_SIZE;
+  }
+  uint32_t checksum = Crc32c(meta, PAGE_USABLE_SIZE);
+  memcpy(meta + PAGE_USABLE_SIZE, &checksum, PAGE_CHECKSUM_SIZE);
+  int fd = open(db_name.c_str(), O_RDWR | O_CREAT, 0666);
+  ASSERT_EQ(PAGE_SIZE, pwrite(fd, meta, PAGE_SIZE, 0));
+
+  // Scenario: the next extent starts a second meta page, placed before its bitmap page.
+  auto *disk_mgr = new DiskManager(db_name);
+  EXPECT_EQ(first_page_id, disk_mgr->AllocatePage());
+  EXPECT_EQ(extents_per_meta_page + 1, reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData())->GetExtentNums());
+  char data[PAGE_SIZE];
+  memset(data, 'm', PAGE_SIZE);
+  disk_mgr->WritePage(first_page_id, data);
+  disk_mgr->Sync();
+  off_t meta_offset = static_cast<off_t>(1 + extents_per_meta_page * (DiskManager::BITMAP_SIZE + 1)) * PAGE_SIZE;
+  ASSERT_EQ(PAGE_SIZE, pread(fd, meta, PAGE_SIZE, meta_offset));
+  EXPECT_EQ(1, meta_page->extent_used_page_[0]);
+  ASSERT_EQ(PAGE_SIZE, pread(fd, data, PAGE_SIZE, meta_offset + 2 * PAGE_SIZE));
+  EXPECT_EQ('m', data[0]);
+  close(fd);
+  delete disk_mgr;
+
+  // Scenario: the chain is read back, and a page freed in any extent is allocated first.
+  disk_mgr = new DiskManager(db_name);
+  EXPECT_FALSE(disk_mgr->IsPageFree(first_page_id));
+  EXPECT_TRUE(disk_mgr->IsPageFree(first_page_id + 1));
+  EXPECT_EQ(first_page_id + 1, disk_mgr->AllocatePage());
+  memset(data, 0, PAGE_SIZE);
+  disk_mgr->ReadPage(first_page_id, data);
+  EXPECT_EQ('m', data[PAGE_SIZE / 2]);
+  disk_mgr->DeAllocatePage(first_page_id);
+  EXPECT_EQ(first_page_id, disk_mgr->AllocatePage());
+  EXPECT_EQ(first_page_id + 2, disk_mgr->AllocatePage());
+  EXPECT_EQ(first_page_id + 3, reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData())->GetAllocatedPages());
+  EXPECT_EQ(0, disk_mgr->GetNumChecksumFailures());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
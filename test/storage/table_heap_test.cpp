@@ -1,5 +1,11 @@
 #include "storage/table_heap.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -63,3 +69,344 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, BulkReadTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(64, disk_mgr_);
+  const int row_nums = 10000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[64];
+  memset(characters, 'x', sizeof(characters));
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+
+  // Scenario: the table is larger than the pool, a scan through a ring with read-ahead still sees every row in order.
+  for (bool bulk_read : {false, true}) {
+    int expected = 0;
+    for (auto it = table_heap->Begin(nullptr, bulk_read); it != table_heap->End(); ++it) {
+      ASSERT_EQ(CmpBool::kTrue, it->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, expected)));
+      expected++;
+    }
+    ASSERT_EQ(row_nums, expected) << "bulk_read " << bulk_read;
+  }
+  ASSERT_TRUE(bpm_->CheckAllUnpinned());
+
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, ContiguousPagesTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(64, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 256, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *heaps[2] = {TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr),
+                         TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr)};
+  char characters[256];
+  memset(characters, 'x', sizeof(characters));
+  // Scenario: two tables growing at the same time do not interleave their pages, each one takes its pages from runs
+  // of contiguous pages.
+  for (int i = 0; i < 2000; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 256, false)};
+    Row row(fields);
+    ASSERT_TRUE(heaps[i % 2]->InsertTuple(row, nullptr));
+  }
+  for (TableHeap *heap : heaps) {
+    int num_pages = 0;
+    int num_adjacent = 0;
+    page_id_t page_id = heap->GetFirstPageId();
+    while (page_id != INVALID_PAGE_ID) {
+      auto guard = bpm_->FetchPageBasic(page_id);
+      page_id_t next_page_id = reinterpret_cast<const TablePage *>(guard.GetPage())->GetNextPageId();
+      num_adjacent += next_page_id == page_id + 1;
+      num_pages++;
+      page_id = next_page_id;
+    }
+    ASSERT_GT(num_pages, 2 * SEGMENT_RUN_PAGES);
+    EXPECT_GE(num_adjacent, num_pages - num_pages / SEGMENT_RUN_PAGES - 1);
+  }
+  delete heaps[0];
+  delete heaps[1];
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+/**
+ * On-disk footprint of a table of repetitive CHAR columns, and time of a cold scan of it, with and without page
+ * compression.
+ */
+TEST(TableHeapTest, CompressionFootprintTest) {
+  const int row_nums = 20000;
+  for (bool compression : {false, true}) {
+    remove(db_file_name.c_str());
+    auto disk_mgr_ = new DiskManager(db_file_name);
+    disk_mgr_->SetPageCompression(compression);
+    // the pages are all cached while the table is filled, and written by the flush
+    auto bpm_ = new BufferPoolManager(1024, disk_mgr_);
+    std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                     new Column("name", TypeId::kTypeChar, 64, 1, false, false),
+                                     new Column("city", TypeId::kTypeChar, 32, 2, false, false)};
+    auto schema = std::make_shared<Schema>(columns);
+    TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+    const char *cities[] = {"Hangzhou", "Shanghai", "Beijing", "Shenzhen"};
+    for (int i = 0; i < row_nums; i++) {
+      std::string name = "customer_" + std::to_string(i % 500);
+      name.resize(64, ' ');
+      std::string city = cities[i % 4];
+      city.resize(32, ' ');
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name.data(), 64, false),
+                    Field(TypeId::kTypeChar, city.data(), 32, false)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    }
+    bpm_->FlushAllPages();
+    disk_mgr_->Sync();
+    page_id_t first_page_id = table_heap->GetFirstPageId();
+    delete table_heap;
+    delete bpm_;
+    bpm_ = new BufferPoolManager(64, disk_mgr_);
+    table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+    uint64_t footprint = 0;
+    for (const char *suffix : {"", ".zdata", ".zmap"}) {
+      struct stat stat_buf;
+      if (stat((db_file_name + suffix).c_str(), &stat_buf) == 0) {
+        footprint += stat_buf.st_blocks * 512;
+        int fd = open((db_file_name + suffix).c_str(), O_RDONLY);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+      }
+    }
+    auto start = std::chrono::steady_clock::now();
+    int num_rows = 0;
+    for (auto it = table_heap->Begin(nullptr, true); it != table_heap->End(); ++it) {
+      num_rows++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_EQ(row_nums, num_rows);
+    EXPECT_EQ(0, disk_mgr_->GetNumChecksumFailures());
+    LOG(INFO) << (compression ? "compressed" : "uncompressed") << ": " << footprint / 1024 << " KiB on disk, "
+              << disk_mgr_->GetNumCompressedPages() << " compressed pages, cold scan " << seconds * 1000 << " ms"
+              << std::endl;
+    delete table_heap;
+    delete bpm_;
+    delete disk_mgr_;
+  }
+  remove(db_file_name.c_str());
+  remove((db_file_name + ".zdata").c_str());
+  remove((db_file_name + ".zmap").c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(64, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 256, 1, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  char characters[256];
+  memset(characters, 'x', sizeof(characters));
+  auto insert = [&](int id) {
+    Fields fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, characters, 256, false)};
+    Row row(fields);
+    EXPECT_TRUE(table_heap->InsertTuple(row, nullptr));
+    return row.GetRowId();
+  };
+  // Scenario: the inserts into a large table take as long as those into a small one, they do not walk the pages.
+  const int row_nums = 40000;
+  const int batch = 2000;
+  std::vector<RowId> rids;
+  double first_batch = 0;
+  double last_batch = 0;
+  for (int i = 0; i < row_nums; i += batch) {
+    auto start = std::chrono::steady_clock::now();
+    for (int j = i; j < i + batch; j++) {
+      rids.push_back(insert(j));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    (i == 0 ? first_batch : last_batch) = seconds;
+  }
+  size_t num_pages = table_heap->GetFreeSpaceMap().GetNumPages();
+  LOG(INFO) << num_pages << " pages, " << batch << " inserts into the empty table " << first_batch * 1000
+            << " ms, into the full table " << last_batch * 1000 << " ms" << std::endl;
+  EXPECT_LT(last_batch, first_batch * 5 + 0.05);
+  // Scenario: the space of deleted tuples is reused, wherever it is in the page chain.
+  table_heap->ApplyDelete(rids[1], nullptr);
+  table_heap->ApplyDelete(rids[2], nullptr);
+  RowId rid = insert(row_nums);
+  EXPECT_EQ(rids[1].GetPageId(), rid.GetPageId());
+  // Scenario: the map survives a restart, the heap keeps growing at its last page. Opening the heap reads the map and
+  // the last page, not the page chain.
+  bpm_->FlushAllPages();
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t last_page_id = table_heap->GetFreeSpaceMap().GetLastPageId();
+  delete table_heap;
+  delete bpm_;
+  bpm_ = new BufferPoolManager(64, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  EXPECT_LT(bpm_->GetStats().Get(BufferPoolStats::kFetches), num_pages / 100);
+  EXPECT_EQ(num_pages, table_heap->GetFreeSpaceMap().GetNumPages());
+  EXPECT_EQ(last_page_id, table_heap->GetFreeSpaceMap().GetLastPageId());
+  EXPECT_EQ(rids[2].GetPageId(), insert(row_nums + 1).GetPageId());
+  for (int i = 0; i < row_nums; i++) {
+    insert(row_nums + 2 + i);
+  }
+  int num_rows = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    num_rows++;
+  }
+  EXPECT_EQ(2 * row_nums, num_rows);
+  EXPECT_LE(table_heap->GetFreeSpaceMap().GetNumPages(), 2 * num_pages + 1);
+  // Scenario: a map older than the heap, listing a page which belongs to someone else now, is corrected when an insert
+  // picks the page, the page is never written to.
+  num_pages = table_heap->GetFreeSpaceMap().GetNumPages();
+  page_id_t foreign_page_id;
+  {
+    auto foreign_guard = bpm_->NewPageGuarded(foreign_page_id);
+    ASSERT_TRUE(foreign_guard.IsValid());
+    auto first_guard = bpm_->FetchPageBasic(first_page_id);
+    page_id_t fsm_page_id = reinterpret_cast<const TablePage *>(first_guard.GetPage())->GetPrevPageId();
+    auto fsm_guard = bpm_->FetchPageWrite(fsm_page_id);
+    while (fsm_guard.As<FreeSpaceMapPage>()->GetNextPageId() != INVALID_PAGE_ID) {
+      fsm_guard = bpm_->FetchPageWrite(fsm_guard.As<FreeSpaceMapPage>()->GetNextPageId());
+    }
+    auto fsm_page = fsm_guard.AsMut<FreeSpaceMapPage>();
+    ASSERT_LT(fsm_page->GetCount(), FreeSpaceMapPage::CAPACITY);
+    fsm_page->SetSlot(fsm_page->GetCount(), foreign_page_id, UINT8_MAX);
+  }
+  bpm_->FlushAllPages();
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  EXPECT_EQ(num_pages + 1, table_heap->GetFreeSpaceMap().GetNumPages());
+  // Once the last page is full the foreign page is the only one with room left.
+  for (int i = 0; i < 100; i++) {
+    EXPECT_NE(foreign_page_id, insert(3 * row_nums + i).GetPageId());
+  }
+  EXPECT_NE(foreign_page_id, table_heap->GetFreeSpaceMap().FindPage(TablePage::SIZE_MAX_ROW));
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  const int row_nums = 2000;
+  auto db = new DBStorageEngine("vacuum_test.db", true, 256);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, true),
+                                   new Column("name", TypeId::kTypeChar, 256, 1, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateTable("t", schema.get(), nullptr, table_info));
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateIndex("t", "t_id", {"id"}, nullptr, index_info, "bptree"));
+  TableHeap *table_heap = table_info->GetTableHeap();
+  char characters[256];
+  memset(characters, 'x', sizeof(characters));
+  auto count_pages = [&]() {
+    int num_pages = 0;
+    for (page_id_t page_id = table_heap->GetFirstPageId(); page_id != INVALID_PAGE_ID; num_pages++) {
+      auto guard = db->bpm_->FetchPageBasic(page_id);
+      page_id = reinterpret_cast<const TablePage *>(guard.GetPage())->GetNextPageId();
+    }
+    return num_pages;
+  };
+  auto key_of = [](int id) {
+    Fields fields{Field(TypeId::kTypeInt, id)};
+    return Row(fields);
+  };
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 256, false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key_of(i), row.GetRowId(), nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  int num_pages = count_pages();
+  // Scenario: three rows out of four are deleted, the pages are left a quarter full.
+  for (int i = 0; i < row_nums; i++) {
+    if (i % 4 != 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->RemoveEntry(key_of(i), rids[i], nullptr));
+    }
+  }
+  ASSERT_EQ(row_nums / 4 * 3, table_heap->GetNumDeadTuples());
+  VacuumStats stats;
+  ASSERT_EQ(DB_TABLE_NOT_EXIST, db->VacuumTable("none", &stats));
+  // One page at a time, every resumed call makes progress.
+  page_id_t resume = INVALID_PAGE_ID;
+  int num_calls = 0;
+  do {
+    ASSERT_EQ(DB_SUCCESS, db->VacuumTable("t", &stats, &resume, 1));
+    ASSERT_LE(++num_calls, 2 * num_pages);
+  } while (resume != INVALID_PAGE_ID);
+  EXPECT_EQ(row_nums / 4 * 3, stats.tuples_removed);
+  EXPECT_EQ(0, table_heap->GetNumDeadTuples());
+  EXPECT_GT(stats.tuples_moved, 0);
+  EXPECT_EQ(num_pages - count_pages(), stats.pages_freed);
+  EXPECT_LE(count_pages(), num_pages / 4 + 1);
+  // The live rows are intact, and the index points to their new RowIds.
+  int num_rows = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    int id = std::stoi(it->GetField(0)->toString());
+    ASSERT_EQ(0, id % 4);
+    std::vector<RowId> result;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key_of(id), result, nullptr));
+    ASSERT_EQ(1, result.size());
+    ASSERT_EQ(it->GetRowId().Get(), result[0].Get());
+    num_rows++;
+  }
+  ASSERT_EQ(row_nums / 4, num_rows);
+  // Nothing is left to reclaim, no page leaves the chain and a page returned by Vacuum stays valid.
+  uint64_t chain_version = table_heap->GetChainVersion();
+  VacuumStats again;
+  ASSERT_EQ(DB_SUCCESS, db->VacuumTable("t", &again));
+  EXPECT_EQ(0, again.tuples_removed);
+  EXPECT_EQ(0, again.pages_freed);
+  EXPECT_EQ(chain_version, table_heap->GetChainVersion());
+
+  // Scenario: a page merged while someone pins it is not counted as freed until a later vacuum frees it.
+  page_id_t second_page_id;
+  {
+    auto guard = db->bpm_->FetchPageBasic(table_heap->GetFirstPageId());
+    second_page_id = reinterpret_cast<const TablePage *>(guard.GetPage())->GetNextPageId();
+  }
+  ASSERT_NE(INVALID_PAGE_ID, second_page_id);
+  std::vector<std::pair<int, RowId>> second_page_rows;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    if (it->GetRowId().GetPageId() == second_page_id) {
+      second_page_rows.emplace_back(std::stoi(it->GetField(0)->toString()), it->GetRowId());
+    }
+  }
+  for (auto &[id, rid] : second_page_rows) {
+    ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->RemoveEntry(key_of(id), rid, nullptr));
+  }
+  num_pages = count_pages();
+  {
+    auto pinned = db->bpm_->FetchPageBasic(second_page_id);
+    VacuumStats merged;
+    ASSERT_EQ(DB_SUCCESS, db->VacuumTable("t", &merged));
+    EXPECT_EQ(num_pages - 1, count_pages());
+    EXPECT_NE(chain_version, table_heap->GetChainVersion());
+    EXPECT_EQ(0, merged.pages_freed);
+    EXPECT_FALSE(db->bpm_->IsPageFree(second_page_id));
+  }
+  VacuumStats freed;
+  ASSERT_EQ(DB_SUCCESS, db->VacuumTable("t", &freed));
+  EXPECT_EQ(1, freed.pages_freed);
+  EXPECT_TRUE(db->bpm_->IsPageFree(second_page_id));
+  delete db;
+}